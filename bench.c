@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fractal.h"
+
+// file the exports are written to and removed from, and the number of runs of
+// each case, the fastest one is reported
+#define BENCH_FILE "bench.bmp"
+#define BENCH_REPEATS 3
+
+///////////////////////////
+// Structure definitions //
+///////////////////////////
+
+// standard viewport, a center and the width of the real axis around it
+typedef struct {
+
+    const char *name;
+    const char *center_x;
+    const char *center_y;
+    const char *scale;
+
+}bench_view_t;
+
+typedef struct {
+
+    int width;
+    int height;
+
+}bench_size_t;
+
+//////////////////////////
+// Function definitions //
+//////////////////////////
+
+void usage(char *program);
+window_t bench_window(const bench_view_t *view, bench_size_t size);
+void run_case(const bench_view_t *view, bench_size_t size, int iterations, int repeats, char *file_name);
+
+
+/////////////
+// Globals //
+/////////////
+
+bench_view_t bench_views[] = {
+    {"full", "-0.75", "0", "3.5"},
+    {"seahorse", "-0.7453", "0.1127", "0.0065"},
+    {"elephant", "0.285", "0.013", "0.02"},
+    {"minibrot", "-1.7685", "0", "0.045"},
+    {"deep", "-0.10109636384562", "0.95628651080914", "1e-17"}
+};
+
+bench_size_t bench_sizes[] = {
+    {640, 360},
+    {1280, 720}
+};
+
+int bench_iterations[] = {256, 2048};
+
+
+////////////////////////////////////////////////////////////////////////////
+// main:                                                                  //
+//   export every standard viewport at every size and iteration limit,   //
+//   printing one CSV line of stage timings per case                      //
+////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv){
+
+    char *kernel_name = NULL;
+    char *file_name = BENCH_FILE;
+    int repeats = BENCH_REPEATS;
+    int quick = FALSE;
+
+    // every case starts cold unless a cache is asked for
+    tile_cache_megabytes = 0;
+
+    // parse command line options
+    int opt;
+    while((opt = getopt(argc, argv, "o:r:qk:t:p:sc:ma:b:")) != -1){
+        switch(opt){
+
+            // scratch file for the exports
+            case 'o':
+                file_name = optarg;
+            break;
+
+            // runs per case
+            case 'r':
+                repeats = atoi(optarg);
+            break;
+
+            // smallest size and limit only
+            case 'q':
+                quick = TRUE;
+            break;
+
+            // force a specific escape kernel
+            case 'k':
+                kernel_name = optarg;
+            break;
+
+            // number of render threads
+            case 't':
+                render_threads = atoi(optarg);
+            break;
+
+            // force a precision tier
+            case 'p':
+                for(precision_override = PRECISION_FLOAT; precision_override < PRECISION_AUTO; precision_override++){
+                    if(strcmp(optarg, precision_names[precision_override]) == 0){
+                        break;
+                    }
+                }
+                if(precision_override == PRECISION_AUTO){
+                    usage(argv[0]);
+                }
+            break;
+
+            // iterate every pixel instead of filling uniform rectangles
+            case 's':
+                strict_render = TRUE;
+            break;
+
+            // tile cache budget in megabytes
+            case 'c':
+                tile_cache_megabytes = atoi(optarg);
+            break;
+
+            // write the exports through a memory mapping
+            case 'm':
+                mapped_export = TRUE;
+            break;
+
+            // supersample edge pixels of every export
+            case 'a':
+                antialias_samples = atoi(optarg);
+            break;
+
+            // draw boundaries from distance estimates
+            case 'b':
+                distance_render = TRUE;
+                boundary_width = atof(optarg);
+            break;
+
+            default:
+                usage(argv[0]);
+
+        }
+    }
+
+    if(repeats < 1 || antialias_samples > ANTIALIAS_MAX_SAMPLES){
+        usage(argv[0]);
+    }
+
+    // default to one render thread per cpu
+    if(render_threads < 1){
+        render_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    // pick fastest escape kernel supported by this cpu
+    init_escape_kernel(kernel_name);
+
+    int n_views = sizeof(bench_views) / sizeof(bench_views[0]);
+    int n_sizes = quick ? 1 : sizeof(bench_sizes) / sizeof(bench_sizes[0]);
+    int n_iterations = quick ? 1 : sizeof(bench_iterations) / sizeof(bench_iterations[0]);
+
+    printf("view,width,height,iterations,precision,kernel,threads,"
+           "compute_s,color_s,write_s,total_s,mpixels_per_s,iterations_run,iterations_per_s\n");
+
+    int v, s, i;
+    for(v = 0; v < n_views; v++){
+        for(s = 0; s < n_sizes; s++){
+            for(i = 0; i < n_iterations; i++){
+                run_case(&bench_views[v], bench_sizes[s], bench_iterations[i], repeats, file_name);
+            }
+        }
+    }
+
+    unlink(file_name);
+
+    // stop render workers and free what the exports kept
+    if(render_pool != NULL){
+        render_pool_destroy(render_pool);
+    }
+    release_frame(&export_cells.frame);
+    free(export_cells.mu);
+    free(export_cells.known);
+    tile_cache_destroy();
+
+    return 0;
+
+}
+
+
+
+////////////////////////////////////////////////
+// usage:                                     //
+//   print command line options and exit      //
+////////////////////////////////////////////////
+void usage(char *program){
+
+    fprintf(stderr, "usage: %s [-o scratch.bmp] [-r repeats] [-q] [-k scalar|sse2|avx2|avx512] [-t threads]\n"
+                    "       [-p float|double|extended|quad|perturb] [-s] [-c megabytes] [-m] [-a samples] [-b pixels]\n", program);
+    exit(1);
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////
+// bench_window:                                                //
+//   window of the given size showing view, the imaginary axis //
+//   follows the aspect ratio                                   //
+//////////////////////////////////////////////////////////////////
+window_t bench_window(const bench_view_t *view, bench_size_t size){
+
+    // edges are found in quad precision, deep scales vanish next to the center in long double
+    coord_t center_x = strtold(view->center_x, NULL);
+    coord_t center_y = strtold(view->center_y, NULL);
+    coord_t half_width = (coord_t)strtold(view->scale, NULL) / 2;
+    coord_t half_height = half_width * size.height / size.width;
+
+    window_t display;
+    display.min_x = center_x - half_width;
+    display.max_x = center_x + half_width;
+    display.min_y = center_y - half_height;
+    display.max_y = center_y + half_height;
+    display.screen_width = size.width;
+    display.screen_height = size.height;
+
+    return display;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// run_case:                                                                 //
+//   export view repeats times from scratch and print the stages of the     //
+//   fastest run                                                             //
+///////////////////////////////////////////////////////////////////////////////
+void run_case(const bench_view_t *view, bench_size_t size, int iterations, int repeats, char *file_name){
+
+    window_t display = bench_window(view, size);
+    iteration_limit = iterations;
+
+    export_timings_t best = {0};
+    double best_total = 0;
+    long best_iterations = 0;
+
+    int run;
+    for(run = 0; run < repeats; run++){
+
+        // without this the second run would only recolor the first
+        release_frame(&export_cells.frame);
+        free(export_cells.mu);
+        free(export_cells.known);
+        memset(&export_cells, 0, sizeof(export_cells));
+
+        double start = monotonic_seconds();
+        draw_bitmap(file_name, display, size.width, size.height, GOLDEN_PURPLE);
+        double total = monotonic_seconds() - start;
+
+        if(run == 0 || total < best_total){
+            best = export_timings;
+            best_total = total;
+            best_iterations = frame_counters.iterations;
+        }
+
+    }
+
+    double pixels = (double)size.width * size.height;
+
+    printf("%s,%d,%d,%d,%s,%s,%d,%.6f,%.6f,%.6f,%.6f,%.3f,%ld,%.0f\n",
+           view->name, size.width, size.height, iterations,
+           precision_names[choose_precision(display)], escape_engine->name, render_threads,
+           best.compute, best.color, best.write, best_total,
+           pixels / best_total / 1e6, best_iterations,
+           best.compute > 0 ? best_iterations / best.compute : 0);
+    fflush(stdout);
+
+}
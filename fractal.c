@@ -0,0 +1,4276 @@
+#include "fractal.h"
+
+
+/////////////
+// Globals //
+/////////////
+
+// kernels of every formula for one instruction set, in FORMULA order
+#define FORMULA_KERNELS(K) {K##_mandelbrot, K##_julia, K##_multibrot3, K##_multibrot4, K##_burning_ship}
+#define FORMULA_DISTANCE_KERNELS(K) {K##_mandelbrot, K##_julia, K##_multibrot3, K##_multibrot4, NULL}
+
+// available escape kernels, fastest first
+escape_engine_t escape_engines[] = {
+    {"avx512", "avx512f", FORMULA_KERNELS(escape_kernel_avx512), FORMULA_KERNELS(escape_kernel_avx512_float),
+     FORMULA_DISTANCE_KERNELS(distance_kernel_avx512), FORMULA_DISTANCE_KERNELS(distance_kernel_avx512_float)},
+    {"avx2", "avx2", FORMULA_KERNELS(escape_kernel_avx2), FORMULA_KERNELS(escape_kernel_avx2_float),
+     FORMULA_DISTANCE_KERNELS(distance_kernel_avx2), FORMULA_DISTANCE_KERNELS(distance_kernel_avx2_float)},
+    {"sse2", "sse2", FORMULA_KERNELS(escape_kernel_sse2), FORMULA_KERNELS(escape_kernel_sse2_float),
+     FORMULA_DISTANCE_KERNELS(distance_kernel_sse2), FORMULA_DISTANCE_KERNELS(distance_kernel_sse2_float)},
+    {"scalar", NULL, FORMULA_KERNELS(escape_kernel_scalar), FORMULA_KERNELS(escape_kernel_scalar_float),
+     FORMULA_DISTANCE_KERNELS(distance_kernel_scalar), FORMULA_DISTANCE_KERNELS(distance_kernel_scalar_float)}
+};
+
+// wider precision kernels of each formula, the same on every instruction set.
+// burning ship has no distance estimate
+formula_kernels_t formula_kernels[] = {
+    {escape_kernel_extended_mandelbrot, escape_kernel_quad_mandelbrot,
+     distance_kernel_extended_mandelbrot, distance_kernel_quad_mandelbrot},
+    {escape_kernel_extended_julia, escape_kernel_quad_julia,
+     distance_kernel_extended_julia, distance_kernel_quad_julia},
+    {escape_kernel_extended_multibrot3, escape_kernel_quad_multibrot3,
+     distance_kernel_extended_multibrot3, distance_kernel_quad_multibrot3},
+    {escape_kernel_extended_multibrot4, escape_kernel_quad_multibrot4,
+     distance_kernel_extended_multibrot4, distance_kernel_quad_multibrot4},
+    {escape_kernel_extended_burning_ship, escape_kernel_quad_burning_ship, NULL, NULL}
+};
+
+// names of FORMULA values, as given on the command line
+char *formula_names[] = {"mandelbrot", "julia", "multibrot3", "multibrot4", "burning_ship"};
+
+// formula being drawn, and the constant c of julia sets
+FORMULA fractal_formula = MANDELBROT;
+coord_t julia_r = DEFAULT_JULIA_R;
+coord_t julia_i = DEFAULT_JULIA_I;
+
+// kernel chosen by init_escape_kernel
+escape_engine_t *escape_engine = &escape_engines[3];
+
+// pixels and iterations of the current frame, by how each pixel was decided
+frame_counters_t frame_counters = {0};
+
+// names of PRECISION values, shown in the info bar
+char *precision_names[] = {"float", "double", "extended", "quad", "perturb", "auto"};
+
+// names of COLOR_PALETTE values, as given on the command line
+char *palette_names[] = {"golden_purple", "pastel_rainbow", "scarlet_gray", "ocean",
+                         "earth", "highlighters", "gray_scale", "matrix"};
+
+// precision forced from the command line, PRECISION_AUTO picks it from the zoom depth
+PRECISION precision_override = PRECISION_AUTO;
+
+// number of render workers, defaults to one per online cpu
+int render_threads = 0;
+render_pool_t *render_pool = NULL;
+
+// iteration limit set from the command line or menu, 0 picks it automatically, and the
+// automatic limit carried from one frame to the next
+int iteration_limit = 0;
+int auto_iterations = 0;
+
+// when set every pixel is iterated, otherwise rectangles with a uniform border are filled
+int strict_render = FALSE;
+
+// tiles shared by the interactive view and bitmap exports, budget set from the command line
+tile_cache_t tile_cache = {PTHREAD_MUTEX_INITIALIZER};
+int tile_cache_megabytes = TILE_CACHE_MEGABYTES;
+
+// when set exports are written through a memory mapping of the file instead of stdio
+int mapped_export = FALSE;
+
+// when set escaping points closer than boundary_width pixels to the set's boundary, by their
+// distance estimate, are drawn as part of the set so thin filaments stay connected
+int distance_render = FALSE;
+double boundary_width = BOUNDARY_WIDTH;
+
+// when above 1, export pixels that differ from a neighbour by more than the threshold are
+// supersampled on an antialias_samples x antialias_samples grid and given the average color
+int antialias_samples = 0;
+double antialias_threshold = ANTIALIAS_THRESHOLD;
+
+// escape values of the last bitmap export, exporting the same view again only recolors them
+cell_buffer_t export_cells = {0};
+
+// stage timings of the last bitmap export
+export_timings_t export_timings = {0};
+
+
+/////////////////////////////////////////////////////////////////////////
+// complex_multiply:                                                   //
+//   multiply two complex_t numbers and return the resulting complex_t //
+/////////////////////////////////////////////////////////////////////////
+complex_t complex_multiply(complex_t x, complex_t y){
+
+    complex_t result;
+
+    result.a = (x.a * y.a) - (x.b * y.b);
+    result.b = (x.a * y.b) + (y.a * x.b);
+
+    return result;
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////
+// complex_add:                                                        //
+//   add two complex_t numbers and return the resulting complex_t      //
+/////////////////////////////////////////////////////////////////////////
+complex_t complex_add(complex_t x, complex_t y){
+
+    complex_t result;
+
+    result.a = x.a + y.a;
+    result.b = x.b + y.b;
+
+    return result;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// complex_sub:                                                                  //
+//   subtract one complex_t from another and return the resulting complex_t      //
+///////////////////////////////////////////////////////////////////////////////////
+complex_t complex_sub(complex_t x, complex_t y){
+
+    complex_t result;
+
+    result.a = x.a - y.a;
+    result.b = x.b - y.b;
+
+    return result;
+
+}
+
+
+
+///////////////////////////////////////////
+// complex_magnitude:                    //
+//   return the magnitude of a complex_t //
+///////////////////////////////////////////
+long double complex_magnitude(complex_t x){
+
+    long double result = sqrt(x.a * x.a + x.b * x.b);
+
+    return result;
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// complex_scale:                                                       //
+//   return the complex_t corresponding to the given cursor coordinates //
+//////////////////////////////////////////////////////////////////////////
+complex_t scale(window_t display, int row, int col){
+
+    // window coords include border so subtract from row and column values to get actual coord on plane
+    int actual_x = col;
+    int actual_y = row;
+
+    complex_t c;
+
+    // window is converted first so the math stays in long double instead of software quad
+    long double min_x = display.min_x;
+    long double max_x = display.max_x;
+    long double min_y = display.min_y;
+    long double max_y = display.max_y;
+
+    // calculate number of complex units corresponding to one cursor width or height
+    long double x_cursor_units = (max_x - min_x)/display.screen_width;
+    long double y_cursor_units = (max_y - min_y)/display.screen_height;
+
+    // calculate position on complex plane relative to position on display
+    c.a = min_x + (actual_x * x_cursor_units);
+    c.b = max_y - (actual_y * y_cursor_units);
+
+    return c;
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////
+// scale_quad:                                                      //
+//   same as scale, but in the full quad precision of the window_t //
+//////////////////////////////////////////////////////////////////////
+void scale_quad(window_t display, int row, int col, __float128 *a, __float128 *b){
+
+    coord_t x_cursor_units = (display.max_x - display.min_x)/display.screen_width;
+    coord_t y_cursor_units = (display.max_y - display.min_y)/display.screen_height;
+
+    *a = display.min_x + (col * x_cursor_units);
+    *b = display.max_y - (row * y_cursor_units);
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// snap_window:                                                            //
+//   round the cell spacing to GRID_BITS significant bits and move the    //
+//   window by less than a cell so its edges are whole multiples of the   //
+//   spacing. every cell is then an exact integer times the spacing, and  //
+//   panning by one cell lands on the same grid without drifting          //
+/////////////////////////////////////////////////////////////////////////////
+void snap_window(window_t *display){
+
+    coord_t x_cursor_units = (display->max_x - display->min_x)/display->screen_width;
+    coord_t y_cursor_units = (display->max_y - display->min_y)/display->screen_height;
+
+    // long double has the exponent range of quad, so frexpl and ldexpl can do the rounding
+    int exponent;
+    long double fraction = frexpl((long double)x_cursor_units, &exponent);
+    x_cursor_units = ldexpl(roundl(ldexpl(fraction, GRID_BITS)), exponent - GRID_BITS);
+
+    fraction = frexpl((long double)y_cursor_units, &exponent);
+    y_cursor_units = ldexpl(roundl(ldexpl(fraction, GRID_BITS)), exponent - GRID_BITS);
+
+    // keep the center where it was, scale measures columns from min_x and rows from max_y
+    coord_t center_x = (display->min_x + display->max_x) / 2;
+    coord_t center_y = (display->min_y + display->max_y) / 2;
+
+    display->min_x = round_coord(center_x / x_cursor_units - (coord_t)display->screen_width / 2) * x_cursor_units;
+    display->max_x = display->min_x + display->screen_width * x_cursor_units;
+    display->max_y = round_coord(center_y / y_cursor_units + (coord_t)display->screen_height / 2) * y_cursor_units;
+    display->min_y = display->max_y - display->screen_height * y_cursor_units;
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// round_coord:                                                       //
+//   round to the nearest integer without libquadmath. adding 2^112   //
+//   leaves no bits below the point in a quad mantissa               //
+////////////////////////////////////////////////////////////////////////
+coord_t round_coord(coord_t x){
+
+    const coord_t shift = (coord_t)(1LL << 56) * (coord_t)(1LL << 56);
+
+    if(x >= shift || x <= -shift){
+        return x;
+    }
+
+    return x < 0 ? (x - shift) + shift : (x + shift) - shift;
+
+}
+
+
+
+//////////////////////////////////////////////////
+// floor_coord:                                 //
+//   largest integer not greater than x         //
+//////////////////////////////////////////////////
+coord_t floor_coord(coord_t x){
+
+    coord_t rounded = round_coord(x);
+    return rounded > x ? rounded - 1 : rounded;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// is_in_set:                                                                //
+//   return 0 if complex_t c is in the mandelbrot set and mu, a normalized   //
+//   valued related to the escape time of the recursive function             //
+//   this is used in calculating the color of each coordinate                //
+///////////////////////////////////////////////////////////////////////////////
+double is_in_set(complex_t c, int iterations){
+
+    // initial z set to 0
+    complex_t z;    
+    z.a = 0;
+    z.b = 0;
+
+    // set escape radius to 2
+    double escape_r = 2.0;
+    double mu;
+
+    // i is iterations completed
+    int i = 0;
+    while(i <= iterations){
+
+        // iterate z value and store result
+        z = complex_add(complex_multiply(z, z), c);
+
+        // increment iteration counter
+        i++;
+        double mag = complex_magnitude(z);
+
+        // if mag is greater than escape radius point is not in set, end loop
+        if (mag > escape_r){
+            break;
+        }
+    }
+
+    // if c is in set calculate mu, normalized escape value
+    if(i < iterations){
+
+        // complete a couple more iterations of z to get cleaner mu value
+        z = complex_add(complex_multiply(z, z), c);
+        i++;
+        z = complex_add(complex_multiply(z, z), c);
+        i++;
+           
+        double mag = complex_magnitude(z);
+        mu = i - ( log( log(mag) ) / log(2.0) );
+
+        // handle occasional NaN results from calculation
+        if(isnan(mu)){
+            mu = 0;
+        }
+
+        // handle negative mu values
+        if(mu < 0){
+            mu *= -1;
+        }
+
+    }else{
+
+        // else set mu to exactly zero
+        mu = 0;
+
+    }
+
+    return mu;
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////
+// init_escape_kernel:                                                    //
+//   select the escape kernel used by compute_span and compute_points,    //
+//   either the one named by requested or the fastest one supported by    //
+//   the running cpu                                                      //
+////////////////////////////////////////////////////////////////////////////
+void init_escape_kernel(const char *requested){
+
+    int n_engines = sizeof(escape_engines) / sizeof(escape_engines[0]);
+
+    int i;
+    for(i = 0; i < n_engines; i++){
+
+        escape_engine_t *engine = &escape_engines[i];
+
+        // skip kernels other than the requested one
+        if(requested != NULL && strcmp(requested, engine->name) != 0){
+            continue;
+        }
+
+        // skip kernels this cpu can't run
+        if(engine->cpu_feature != NULL && !cpu_supports(engine->cpu_feature)){
+            continue;
+        }
+
+        escape_engine = engine;
+        return;
+
+    }
+
+    // requested kernel unknown or unsupported, fall back to best available
+    if(requested != NULL){
+        fprintf(stderr, "escape kernel '%s' not available\n", requested);
+        init_escape_kernel(NULL);
+    }
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////
+// cpu_supports:                                                //
+//   return nonzero if the running cpu has the named extension //
+//////////////////////////////////////////////////////////////////
+int cpu_supports(const char *feature){
+
+    // __builtin_cpu_supports only accepts string literals
+    __builtin_cpu_init();
+
+    if(strcmp(feature, "avx512f") == 0){
+        return __builtin_cpu_supports("avx512f");
+    }else if(strcmp(feature, "avx2") == 0){
+        return __builtin_cpu_supports("avx2");
+    }else if(strcmp(feature, "sse2") == 0){
+        return __builtin_cpu_supports("sse2");
+    }
+
+    return 0;
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////
+// add_frame_counters:                                              //
+//   add what one batch of pixels cost to the frame's counters.     //
+//   kernels run on several workers so the counters are atomic      //
+//////////////////////////////////////////////////////////////////////
+void add_frame_counters(const frame_counters_t *counts){
+
+    __atomic_fetch_add(&frame_counters.cardioid, counts->cardioid, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&frame_counters.bulb, counts->bulb, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&frame_counters.periodic, counts->periodic, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&frame_counters.filled, counts->filled, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&frame_counters.escaped, counts->escaped, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&frame_counters.exhausted, counts->exhausted, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&frame_counters.iterations, counts->iterations, __ATOMIC_RELAXED);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// formulas:                                                                     //
+//   each formula is a set of macros the kernels are generated from, written    //
+//   so they work on scalars of any REAL and on gcc vectors alike:              //
+//     START_f       z, c and dz/dc before the first iteration, from the point  //
+//                   (x, y) and the julia constant                              //
+//     INTERIOR_f    masks of points known to be in the set without iterating  //
+//     NEXT_f        z of the next iteration, ABS takes the absolute value of a //
+//                   VD for formulas that fold z                                //
+//     DERIVATIVE_f  dz/dc of the next iteration, from z before it is advanced  //
+///////////////////////////////////////////////////////////////////////////////////
+#define SCALAR_ABS(a) ((a) < 0 ? -(a) : (a))
+
+// z^2 + c from z = 0, the main cardioid and period 2 bulb have closed forms
+#define START_mandelbrot(VD, x, y, constant_r, constant_i, zr, zi, cr, ci, der_r, der_i) \
+{                                                                                   \
+    zr = (VD){0};                                                                   \
+    zi = (VD){0};                                                                   \
+    cr = x;                                                                         \
+    ci = y;                                                                         \
+    der_r = (VD){0};                                                                \
+    der_i = (VD){0};                                                                \
+}
+
+#define INTERIOR_mandelbrot(VD, VI, REAL, cr, ci, cardioid, bulb)                   \
+{                                                                                   \
+    VD a = cr - (REAL)0.25;                                                         \
+    VD b2 = ci * ci;                                                                \
+    VD q = a * a + b2;                                                              \
+    cardioid = (q * (q + a) <= b2 * (REAL)0.25);                                    \
+    bulb = ((cr + 1) * (cr + 1) + b2 <= (REAL)0.0625) & ~cardioid;                  \
+}
+
+#define NEXT_mandelbrot(VD, ABS, zr, zi, cr, ci, next_r, next_i)                    \
+{                                                                                   \
+    next_r = zr * zr - zi * zi + cr;                                                \
+    next_i = (zr + zr) * zi + ci;                                                   \
+}
+
+#define DERIVATIVE_mandelbrot(VD, zr, zi, der_r, der_i, next_r, next_i)             \
+{                                                                                   \
+    VD s = zr * der_r - zi * der_i;                                                 \
+    VD v = zr * der_i + zi * der_r;                                                 \
+    next_r = s + s + 1;                                                             \
+    next_i = v + v;                                                                 \
+}
+
+// z^2 + c from z at the point, the derivative is taken along z_0 so it starts at 1
+#define START_julia(VD, x, y, constant_r, constant_i, zr, zi, cr, ci, der_r, der_i) \
+{                                                                                   \
+    zr = x;                                                                         \
+    zi = y;                                                                         \
+    cr = (VD){0} + constant_r;                                                      \
+    ci = (VD){0} + constant_i;                                                      \
+    der_r = (VD){0} + 1;                                                            \
+    der_i = (VD){0};                                                                \
+}
+
+#define INTERIOR_julia(VD, VI, REAL, cr, ci, cardioid, bulb)                        \
+{                                                                                   \
+    cardioid = (VI){0};                                                             \
+    bulb = (VI){0};                                                                 \
+}
+
+#define NEXT_julia NEXT_mandelbrot
+
+#define DERIVATIVE_julia(VD, zr, zi, der_r, der_i, next_r, next_i)                  \
+{                                                                                   \
+    VD s = zr * der_r - zi * der_i;                                                 \
+    VD v = zr * der_i + zi * der_r;                                                 \
+    next_r = s + s;                                                                 \
+    next_i = v + v;                                                                 \
+}
+
+// z^3 + c and z^4 + c from z = 0
+#define START_multibrot3 START_mandelbrot
+#define INTERIOR_multibrot3 INTERIOR_julia
+
+#define NEXT_multibrot3(VD, ABS, zr, zi, cr, ci, next_r, next_i)                    \
+{                                                                                   \
+    VD zr2 = zr * zr;                                                               \
+    VD zi2 = zi * zi;                                                               \
+    next_r = zr * (zr2 - 3 * zi2) + cr;                                             \
+    next_i = zi * (3 * zr2 - zi2) + ci;                                             \
+}
+
+#define DERIVATIVE_multibrot3(VD, zr, zi, der_r, der_i, next_r, next_i)             \
+{                                                                                   \
+    VD z2r = zr * zr - zi * zi;                                                     \
+    VD z2i = (zr + zr) * zi;                                                        \
+    next_r = 3 * (z2r * der_r - z2i * der_i) + 1;                                   \
+    next_i = 3 * (z2r * der_i + z2i * der_r);                                       \
+}
+
+#define START_multibrot4 START_mandelbrot
+#define INTERIOR_multibrot4 INTERIOR_julia
+
+#define NEXT_multibrot4(VD, ABS, zr, zi, cr, ci, next_r, next_i)                    \
+{                                                                                   \
+    VD z2r = zr * zr - zi * zi;                                                     \
+    VD z2i = (zr + zr) * zi;                                                        \
+    next_r = z2r * z2r - z2i * z2i + cr;                                            \
+    next_i = (z2r + z2r) * z2i + ci;                                                \
+}
+
+#define DERIVATIVE_multibrot4(VD, zr, zi, der_r, der_i, next_r, next_i)             \
+{                                                                                   \
+    VD z2r = zr * zr - zi * zi;                                                     \
+    VD z2i = (zr + zr) * zi;                                                        \
+    VD z3r = z2r * zr - z2i * zi;                                                   \
+    VD z3i = z2r * zi + z2i * zr;                                                   \
+    next_r = 4 * (z3r * der_r - z3i * der_i) + 1;                                   \
+    next_i = 4 * (z3r * der_i + z3i * der_r);                                       \
+}
+
+// (|re z| + i |im z|)^2 + c from z = 0. folding z isn't complex differentiable, so
+// there is no distance estimate and the derivative is left alone
+#define START_burning_ship START_mandelbrot
+#define INTERIOR_burning_ship INTERIOR_julia
+
+#define NEXT_burning_ship(VD, ABS, zr, zi, cr, ci, next_r, next_i)                  \
+{                                                                                   \
+    next_r = zr * zr - zi * zi + cr;                                                \
+    next_i = ABS((zr + zr) * zi) + ci;                                              \
+}
+
+#define DERIVATIVE_burning_ship(VD, zr, zi, der_r, der_i, next_r, next_i)           \
+{                                                                                   \
+    next_r = der_r;                                                                 \
+    next_i = der_i;                                                                 \
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DEFINE_SMOOTH:                                                            //
+//   generate smooth_escape_f, which given z at the iteration i where it    //
+//   escaped returns mu the same way is_in_set does, or 0 if the point      //
+//   never escaped within iterations, and smooth_distance_f, which given    //
+//   dz/dc too returns the estimated distance from the point to the set's   //
+//   boundary, |z| ln|z| / |dz/dc|. the estimate only holds once |z| is well //
+//   past the escape radius, and points whose derivative overflowed are at  //
+//   distance 0. POWER is the degree of the formula                         //
+///////////////////////////////////////////////////////////////////////////////
+#define DEFINE_SMOOTH(FORMULA, POWER)                                               \
+static inline double smooth_escape_##FORMULA(double zr, double zi, double cr, double ci, int i, int iterations){ \
+                                                                                    \
+    if(i >= iterations){                                                            \
+        return 0;                                                                   \
+    }                                                                               \
+                                                                                    \
+    /* complete a couple more iterations of z to get cleaner mu value */           \
+    int k;                                                                          \
+    for(k = 0; k < 2; k++){                                                         \
+        double t, u;                                                                \
+        NEXT_##FORMULA(double, SCALAR_ABS, zr, zi, cr, ci, t, u)                    \
+        zr = t;                                                                     \
+        zi = u;                                                                     \
+        i++;                                                                        \
+    }                                                                               \
+                                                                                    \
+    double mag = sqrt(zr * zr + zi * zi);                                           \
+    double mu = i - ( log( log(mag) ) / log(POWER) );                               \
+                                                                                    \
+    /* handle occasional NaN results from calculation */                            \
+    if(isnan(mu)){                                                                  \
+        mu = 0;                                                                     \
+    }                                                                               \
+                                                                                    \
+    /* handle negative mu values */                                                 \
+    if(mu < 0){                                                                     \
+        mu *= -1;                                                                   \
+    }                                                                               \
+                                                                                    \
+    return mu;                                                                      \
+                                                                                    \
+}                                                                                   \
+                                                                                    \
+static inline double smooth_distance_##FORMULA(double zr, double zi, double der_r, double der_i, \
+                                               double cr, double ci, int i, int iterations){ \
+                                                                                    \
+    if(i >= iterations){                                                            \
+        return 0;                                                                   \
+    }                                                                               \
+                                                                                    \
+    int k;                                                                          \
+    for(k = 0; k < DISTANCE_STEPS && zr * zr + zi * zi < DISTANCE_RADIUS * DISTANCE_RADIUS; k++){ \
+        double next_der_r, next_der_i, t, u;                                        \
+        DERIVATIVE_##FORMULA(double, zr, zi, der_r, der_i, next_der_r, next_der_i)  \
+        NEXT_##FORMULA(double, SCALAR_ABS, zr, zi, cr, ci, t, u)                    \
+        der_r = next_der_r;                                                         \
+        der_i = next_der_i;                                                         \
+        zr = t;                                                                     \
+        zi = u;                                                                     \
+    }                                                                               \
+                                                                                    \
+    double mag = sqrt(zr * zr + zi * zi);                                           \
+    double distance = mag * log(mag) / sqrt(der_r * der_r + der_i * der_i);         \
+                                                                                    \
+    /* an infinite derivative leaves 0 or NaN, the point is far closer than any pixel */ \
+    if(!(distance > 0)){                                                            \
+        distance = 0;                                                               \
+    }                                                                               \
+                                                                                    \
+    return distance;                                                                \
+                                                                                    \
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// DEFINE_SCALAR_KERNEL:                                                     //
+//   generate an escape kernel for FORMULA iterating each point on its own  //
+//   in REAL, used when no vector unit is present and for the wider         //
+//   precision tiers. points the formula knows to be inside are skipped,    //
+//   and orbits that come back within a few EPSILON of a saved point are    //
+//   stopped early (Brent's method, the saved point moves after 1, 2, 4,    //
+//   8... iterations). the loop is inlined into the escape kernel and into  //
+//   the one DEFINE_SCALAR_DISTANCE adds, where derivative is a constant    //
+///////////////////////////////////////////////////////////////////////////////
+#define DEFINE_SCALAR_KERNEL(NAME, FORMULA, REAL, EPSILON)                          \
+static inline __attribute__((always_inline))                                        \
+void NAME##_iterate(const REAL *x, const REAL *y, double *mu, double *distance, int n, const frame_t *frame, \
+                    int derivative){                                                \
+                                                                                    \
+    frame_counters_t counts = {0};                                                  \
+    REAL tolerance = 4 * EPSILON;                                                   \
+    int iterations = frame->iterations;                                             \
+                                                                                    \
+    int k;                                                                          \
+    for(k = 0; k < n; k++){                                                         \
+                                                                                    \
+        /* closed form tests for the largest components of the set */              \
+        int cardioid, bulb;                                                         \
+        INTERIOR_##FORMULA(REAL, int, REAL, x[k], y[k], cardioid, bulb)             \
+                                                                                    \
+        if(cardioid){                                                               \
+            mu[k] = 0;                                                              \
+            if(derivative){                                                         \
+                distance[k] = 0;                                                    \
+            }                                                                       \
+            counts.cardioid++;                                                      \
+            continue;                                                               \
+        }                                                                           \
+                                                                                    \
+        if(bulb){                                                                   \
+            mu[k] = 0;                                                              \
+            if(derivative){                                                         \
+                distance[k] = 0;                                                    \
+            }                                                                       \
+            counts.bulb++;                                                          \
+            continue;                                                               \
+        }                                                                           \
+                                                                                    \
+        REAL zr, zi, cr, ci, der_r, der_i;                                          \
+        START_##FORMULA(REAL, x[k], y[k], (REAL)frame->julia_r, (REAL)frame->julia_i, zr, zi, cr, ci, der_r, der_i) \
+        REAL saved_r = zr;                                                          \
+        REAL saved_i = zi;                                                          \
+        int steps = 0, check = 1, cycling = FALSE;                                  \
+                                                                                    \
+        /* i is the iteration at which z escaped or the orbit was found cycling */  \
+        int i;                                                                      \
+        for(i = 1; i < iterations; i++){                                            \
+                                                                                    \
+            if(derivative){                                                         \
+                REAL next_der_r, next_der_i;                                        \
+                DERIVATIVE_##FORMULA(REAL, zr, zi, der_r, der_i, next_der_r, next_der_i) \
+                der_r = next_der_r;                                                 \
+                der_i = next_der_i;                                                 \
+            }                                                                       \
+                                                                                    \
+            REAL t, u;                                                              \
+            NEXT_##FORMULA(REAL, SCALAR_ABS, zr, zi, cr, ci, t, u)                  \
+            zr = t;                                                                 \
+            zi = u;                                                                 \
+                                                                                    \
+            if(zr * zr + zi * zi > 4){                                              \
+                break;                                                              \
+            }                                                                       \
+                                                                                    \
+            /* orbit is back at the saved point, it's cycling and won't escape */  \
+            REAL dr = zr - saved_r;                                                 \
+            REAL di = zi - saved_i;                                                 \
+            if(dr <= tolerance && dr >= -tolerance && di <= tolerance && di >= -tolerance){ \
+                cycling = TRUE;                                                     \
+                counts.periodic++;                                                  \
+                break;                                                              \
+            }                                                                       \
+                                                                                    \
+            if(++steps == check){                                                   \
+                saved_r = zr;                                                       \
+                saved_i = zi;                                                       \
+                steps = 0;                                                          \
+                check *= 2;                                                         \
+            }                                                                       \
+                                                                                    \
+        }                                                                           \
+                                                                                    \
+        counts.iterations += i;                                                     \
+        counts.escaped += i < iterations && !cycling;                               \
+        counts.exhausted += i == iterations;                                        \
+        mu[k] = smooth_escape_##FORMULA(zr, zi, cr, ci, cycling ? iterations : i, iterations); \
+        if(derivative){                                                             \
+            distance[k] = smooth_distance_##FORMULA(zr, zi, der_r, der_i, cr, ci, cycling ? iterations : i, iterations); \
+        }                                                                           \
+                                                                                    \
+    }                                                                               \
+                                                                                    \
+    add_frame_counters(&counts);                                                    \
+                                                                                    \
+}                                                                                   \
+                                                                                    \
+void NAME(const REAL *x, const REAL *y, double *mu, int n, const frame_t *frame){   \
+    NAME##_iterate(x, y, mu, NULL, n, frame, FALSE);                                \
+}
+
+#define DEFINE_SCALAR_DISTANCE(NAME, DISTANCE_NAME, REAL)                           \
+void DISTANCE_NAME(const REAL *x, const REAL *y, double *mu, double *distance, int n, const frame_t *frame){ \
+    NAME##_iterate(x, y, mu, distance, n, frame, TRUE);                             \
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// VECTOR_STEP:                                                                  //
+//   advance one lane group by a single iteration of FORMULA, lanes that have   //
+//   already escaped are frozen with the active mask so z and the count stay put //
+///////////////////////////////////////////////////////////////////////////////////
+#define VECTOR_STEP(VD, VI, FORMULA, ABS, zr, zi, cr, ci, counts, active)          \
+{                                                                                   \
+    VD t, u;                                                                        \
+    NEXT_##FORMULA(VD, ABS, zr, zi, cr, ci, t, u)                                   \
+    zr = (VD)(((VI)t & active) | ((VI)zr & ~active));                               \
+    zi = (VD)(((VI)u & active) | ((VI)zi & ~active));                               \
+    counts -= active;                                                               \
+    active &= (zr * zr + zi * zi <= 4);                                             \
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// VECTOR_DERIVATIVE:                                                            //
+//   advance dz/dc of one lane group, run before VECTOR_STEP moves z on         //
+///////////////////////////////////////////////////////////////////////////////////
+#define VECTOR_DERIVATIVE(VD, VI, FORMULA, zr, zi, der_r, der_i, active)            \
+{                                                                                   \
+    VD next_der_r, next_der_i;                                                      \
+    DERIVATIVE_##FORMULA(VD, zr, zi, der_r, der_i, next_der_r, next_der_i)          \
+    der_r = (VD)(((VI)next_der_r & active) | ((VI)der_r & ~active));                \
+    der_i = (VD)(((VI)next_der_i & active) | ((VI)der_i & ~active));                \
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// VECTOR_PERIOD:                                                                //
+//   stop lanes whose orbit came back within tolerance of their saved point     //
+///////////////////////////////////////////////////////////////////////////////////
+#define VECTOR_PERIOD(VD, VI, zr, zi, saved_r, saved_i, active, periodic, tolerance) \
+{                                                                                   \
+    VD dr = zr - saved_r;                                                           \
+    VD di = zi - saved_i;                                                           \
+    VI same = active & (dr <= tolerance) & (dr >= -tolerance)                       \
+                     & (di <= tolerance) & (di >= -tolerance);                      \
+    periodic |= same;                                                               \
+    active &= ~same;                                                                \
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// DEFINE_VECTOR_KERNEL:                                                         //
+//   generate an escape kernel for FORMULA iterating 2*LANES points of type     //
+//   REAL at once using gcc vector extensions compiled for the TARGET           //
+//   instruction set. INT is the integer type of the same width as REAL. two   //
+//   lane groups are iterated side by side so one hides the other's multiply   //
+//   latency. the interior and periodicity shortcuts match                     //
+//   DEFINE_SCALAR_KERNEL, and so does DEFINE_VECTOR_DISTANCE                  //
+///////////////////////////////////////////////////////////////////////////////////
+#define DEFINE_VECTOR_KERNEL(NAME, FORMULA, TARGET, REAL, INT, LANES, EPSILON)      \
+typedef REAL NAME##_vd __attribute__((vector_size(LANES * sizeof(REAL))));          \
+typedef INT NAME##_vi __attribute__((vector_size(LANES * sizeof(REAL))));           \
+                                                                                    \
+static inline __attribute__((target(TARGET), always_inline))                        \
+NAME##_vd NAME##_abs(NAME##_vd a){                                                  \
+    NAME##_vi negative = a < 0;                                                     \
+    return (NAME##_vd)(((NAME##_vi)(-a) & negative) | ((NAME##_vi)a & ~negative));  \
+}                                                                                   \
+                                                                                    \
+static inline __attribute__((target(TARGET), always_inline))                        \
+void NAME##_iterate(const REAL *x, const REAL *y, double *mu, double *distance, int n, const frame_t *frame, \
+                    int derivative){                                                \
+                                                                                    \
+    frame_counters_t counts = {0};                                                  \
+    REAL tolerance = 4 * EPSILON;                                                   \
+    int iterations = frame->iterations;                                             \
+                                                                                    \
+    int base;                                                                       \
+    for(base = 0; base < n; base += 2 * LANES){                                     \
+                                                                                    \
+        NAME##_vd x0, y0, x1, y1;                                                   \
+        int l;                                                                      \
+                                                                                    \
+        /* pad partial groups with a point that escapes immediately */             \
+        for(l = 0; l < LANES; l++){                                                 \
+            x0[l] = (base + l < n) ? x[base + l] : 4.0;                             \
+            y0[l] = (base + l < n) ? y[base + l] : 0.0;                             \
+            x1[l] = (base + LANES + l < n) ? x[base + LANES + l] : 4.0;             \
+            y1[l] = (base + LANES + l < n) ? y[base + LANES + l] : 0.0;             \
+        }                                                                           \
+                                                                                    \
+        NAME##_vd zr0, zi0, zr1, zi1, cr0, ci0, cr1, ci1;                           \
+        NAME##_vd der_r0, der_i0, der_r1, der_i1;                                   \
+        START_##FORMULA(NAME##_vd, x0, y0, (REAL)frame->julia_r, (REAL)frame->julia_i, zr0, zi0, cr0, ci0, der_r0, der_i0) \
+        START_##FORMULA(NAME##_vd, x1, y1, (REAL)frame->julia_r, (REAL)frame->julia_i, zr1, zi1, cr1, ci1, der_r1, der_i1) \
+                                                                                    \
+        NAME##_vd saved_r0 = zr0, saved_i0 = zi0, saved_r1 = zr1, saved_i1 = zi1;   \
+        NAME##_vi counts0 = {0}, counts1 = {0};                                     \
+        NAME##_vi periodic0 = {0}, periodic1 = {0};                                 \
+        NAME##_vi cardioid0, cardioid1, bulb0, bulb1;                               \
+                                                                                    \
+        /* lanes known to be inside never start iterating */                       \
+        INTERIOR_##FORMULA(NAME##_vd, NAME##_vi, REAL, x0, y0, cardioid0, bulb0)    \
+        INTERIOR_##FORMULA(NAME##_vd, NAME##_vi, REAL, x1, y1, cardioid1, bulb1)    \
+        NAME##_vi active0 = ~(cardioid0 | bulb0), active1 = ~(cardioid1 | bulb1);   \
+                                                                                    \
+        int i, steps = 0, check = 1;                                                \
+        for(i = 1; i < iterations; i++){                                            \
+                                                                                    \
+            if(derivative){                                                         \
+                VECTOR_DERIVATIVE(NAME##_vd, NAME##_vi, FORMULA, zr0, zi0, der_r0, der_i0, active0) \
+                VECTOR_DERIVATIVE(NAME##_vd, NAME##_vi, FORMULA, zr1, zi1, der_r1, der_i1, active1) \
+            }                                                                       \
+                                                                                    \
+            VECTOR_STEP(NAME##_vd, NAME##_vi, FORMULA, NAME##_abs, zr0, zi0, cr0, ci0, counts0, active0) \
+            VECTOR_STEP(NAME##_vd, NAME##_vi, FORMULA, NAME##_abs, zr1, zi1, cr1, ci1, counts1, active1) \
+            VECTOR_PERIOD(NAME##_vd, NAME##_vi, zr0, zi0, saved_r0, saved_i0, active0, periodic0, tolerance) \
+            VECTOR_PERIOD(NAME##_vd, NAME##_vi, zr1, zi1, saved_r1, saved_i1, active1, periodic1, tolerance) \
+                                                                                    \
+            /* all lanes share the same schedule for moving the saved point */     \
+            if(++steps == check){                                                   \
+                saved_r0 = zr0;                                                     \
+                saved_i0 = zi0;                                                     \
+                saved_r1 = zr1;                                                     \
+                saved_i1 = zi1;                                                     \
+                steps = 0;                                                          \
+                check *= 2;                                                         \
+            }                                                                       \
+                                                                                    \
+            /* horizontal test is costly, only check every few iterations */       \
+            if((i & 7) == 1){                                                       \
+                NAME##_vi any = active0 | active1;                                  \
+                INT found = 0;                                                      \
+                for(l = 0; l < LANES; l++){                                         \
+                    found |= any[l];                                                \
+                }                                                                   \
+                if(!found){                                                         \
+                    break;                                                          \
+                }                                                                   \
+            }                                                                       \
+                                                                                    \
+        }                                                                           \
+                                                                                    \
+        for(l = 0; l < 2 * LANES && base + l < n; l++){                             \
+            int g = l / LANES;                                                      \
+            int lane = l % LANES;                                                   \
+            double zr_l = g ? zr1[lane] : zr0[lane];                                \
+            double zi_l = g ? zi1[lane] : zi0[lane];                                \
+            double cr_l = g ? cr1[lane] : cr0[lane];                                \
+            double ci_l = g ? ci1[lane] : ci0[lane];                                \
+            int still_active = g ? active1[lane] != 0 : active0[lane] != 0;         \
+            int in_cardioid = g ? cardioid1[lane] != 0 : cardioid0[lane] != 0;      \
+            int in_bulb = g ? bulb1[lane] != 0 : bulb0[lane] != 0;                  \
+            int cycling = g ? periodic1[lane] != 0 : periodic0[lane] != 0;          \
+            int escape_i = g ? counts1[lane] : counts0[lane];                       \
+            counts.iterations += escape_i;                                          \
+            if(still_active || in_cardioid || in_bulb || cycling){                  \
+                escape_i = iterations;                                              \
+            }else{                                                                  \
+                counts.escaped++;                                                   \
+            }                                                                       \
+            counts.cardioid += in_cardioid;                                         \
+            counts.bulb += in_bulb;                                                 \
+            counts.periodic += cycling;                                             \
+            counts.exhausted += still_active;                                       \
+            mu[base + l] = smooth_escape_##FORMULA(zr_l, zi_l, cr_l, ci_l, escape_i, iterations); \
+            if(derivative){                                                         \
+                double der_r = g ? der_r1[lane] : der_r0[lane];                     \
+                double der_i = g ? der_i1[lane] : der_i0[lane];                     \
+                distance[base + l] = smooth_distance_##FORMULA(zr_l, zi_l, der_r, der_i, cr_l, ci_l, escape_i, iterations); \
+            }                                                                       \
+        }                                                                           \
+                                                                                    \
+    }                                                                               \
+                                                                                    \
+    add_frame_counters(&counts);                                                    \
+                                                                                    \
+}                                                                                   \
+                                                                                    \
+__attribute__((target(TARGET)))                                                     \
+void NAME(const REAL *x, const REAL *y, double *mu, int n, const frame_t *frame){   \
+    NAME##_iterate(x, y, mu, NULL, n, frame, FALSE);                                \
+}
+
+#define DEFINE_VECTOR_DISTANCE(NAME, DISTANCE_NAME, TARGET, REAL)                   \
+__attribute__((target(TARGET)))                                                     \
+void DISTANCE_NAME(const REAL *x, const REAL *y, double *mu, double *distance, int n, const frame_t *frame){ \
+    NAME##_iterate(x, y, mu, distance, n, frame, TRUE);                             \
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////
+// DEFINE_FORMULA:                                                               //
+//   generate the escape kernels of FORMULA for every instruction set and       //
+//   precision tier, so each has its own loop with the formula inlined.         //
+//   vector kernels use one register per lane group. DEFINE_FORMULA_DISTANCE    //
+//   adds their distance kernels                                                //
+///////////////////////////////////////////////////////////////////////////////////
+#define DEFINE_FORMULA(FORMULA, POWER)                                              \
+DEFINE_SMOOTH(FORMULA, POWER)                                                       \
+DEFINE_SCALAR_KERNEL(escape_kernel_scalar_##FORMULA, FORMULA, double, DBL_EPSILON)  \
+DEFINE_SCALAR_KERNEL(escape_kernel_scalar_float_##FORMULA, FORMULA, float, FLT_EPSILON) \
+DEFINE_SCALAR_KERNEL(escape_kernel_extended_##FORMULA, FORMULA, long double, LDBL_EPSILON) \
+DEFINE_SCALAR_KERNEL(escape_kernel_quad_##FORMULA, FORMULA, __float128, __FLT128_EPSILON__) \
+DEFINE_VECTOR_KERNEL(escape_kernel_sse2_##FORMULA, FORMULA, "sse2", double, long long, 2, DBL_EPSILON) \
+DEFINE_VECTOR_KERNEL(escape_kernel_avx2_##FORMULA, FORMULA, "avx2", double, long long, 4, DBL_EPSILON) \
+DEFINE_VECTOR_KERNEL(escape_kernel_avx512_##FORMULA, FORMULA, "avx512f", double, long long, 8, DBL_EPSILON) \
+DEFINE_VECTOR_KERNEL(escape_kernel_sse2_float_##FORMULA, FORMULA, "sse2", float, int, 4, FLT_EPSILON) \
+DEFINE_VECTOR_KERNEL(escape_kernel_avx2_float_##FORMULA, FORMULA, "avx2", float, int, 8, FLT_EPSILON) \
+DEFINE_VECTOR_KERNEL(escape_kernel_avx512_float_##FORMULA, FORMULA, "avx512f", float, int, 16, FLT_EPSILON)
+
+#define DEFINE_FORMULA_DISTANCE(FORMULA)                                            \
+DEFINE_SCALAR_DISTANCE(escape_kernel_scalar_##FORMULA, distance_kernel_scalar_##FORMULA, double) \
+DEFINE_SCALAR_DISTANCE(escape_kernel_scalar_float_##FORMULA, distance_kernel_scalar_float_##FORMULA, float) \
+DEFINE_SCALAR_DISTANCE(escape_kernel_extended_##FORMULA, distance_kernel_extended_##FORMULA, long double) \
+DEFINE_SCALAR_DISTANCE(escape_kernel_quad_##FORMULA, distance_kernel_quad_##FORMULA, __float128) \
+DEFINE_VECTOR_DISTANCE(escape_kernel_sse2_##FORMULA, distance_kernel_sse2_##FORMULA, "sse2", double) \
+DEFINE_VECTOR_DISTANCE(escape_kernel_avx2_##FORMULA, distance_kernel_avx2_##FORMULA, "avx2", double) \
+DEFINE_VECTOR_DISTANCE(escape_kernel_avx512_##FORMULA, distance_kernel_avx512_##FORMULA, "avx512f", double) \
+DEFINE_VECTOR_DISTANCE(escape_kernel_sse2_float_##FORMULA, distance_kernel_sse2_float_##FORMULA, "sse2", float) \
+DEFINE_VECTOR_DISTANCE(escape_kernel_avx2_float_##FORMULA, distance_kernel_avx2_float_##FORMULA, "avx2", float) \
+DEFINE_VECTOR_DISTANCE(escape_kernel_avx512_float_##FORMULA, distance_kernel_avx512_float_##FORMULA, "avx512f", float)
+
+DEFINE_FORMULA(mandelbrot, 2)
+DEFINE_FORMULA(julia, 2)
+DEFINE_FORMULA(multibrot3, 3)
+DEFINE_FORMULA(multibrot4, 4)
+DEFINE_FORMULA(burning_ship, 2)
+DEFINE_FORMULA_DISTANCE(mandelbrot)
+DEFINE_FORMULA_DISTANCE(julia)
+DEFINE_FORMULA_DISTANCE(multibrot3)
+DEFINE_FORMULA_DISTANCE(multibrot4)
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+// choose_precision:                                                        //
+//   pick the cheapest precision tier whose rounding error on coordinates  //
+//   and z stays a small fraction of the pixel spacing of display, or      //
+//   perturbation once even extended precision isn't enough. perturbation  //
+//   only knows the mandelbrot formula, the others fall back to quad       //
+//////////////////////////////////////////////////////////////////////////////
+PRECISION choose_precision(window_t display){
+
+    PRECISION deepest = fractal_formula == MANDELBROT ? PRECISION_PERTURBATION : PRECISION_QUAD;
+
+    if(precision_override == PRECISION_PERTURBATION){
+        return deepest;
+    }else if(precision_override != PRECISION_AUTO){
+        return precision_override;
+    }
+
+    // smallest distance between neighbouring pixels
+    coord_t x_spacing = (display.max_x - display.min_x)/display.screen_width;
+    coord_t y_spacing = (display.max_y - display.min_y)/display.screen_height;
+    coord_t spacing = x_spacing < y_spacing ? x_spacing : y_spacing;
+
+    // largest magnitude a coordinate or z takes before escaping
+    coord_t magnitude = 2;
+    coord_t bounds[4] = {display.min_x, display.max_x, display.min_y, display.max_y};
+
+    int i;
+    for(i = 0; i < 4; i++){
+        coord_t bound = bounds[i] < 0 ? -bounds[i] : bounds[i];
+        if(bound > magnitude){
+            magnitude = bound;
+        }
+    }
+
+    // rounding error of each tier relative to one pixel
+    coord_t error = magnitude * PRECISION_MARGIN / spacing;
+
+    if(error * FLT_EPSILON <= 1){
+        return PRECISION_FLOAT;
+    }else if(error * DBL_EPSILON <= 1){
+        return PRECISION_DOUBLE;
+    }else if(error * LDBL_EPSILON <= 1){
+        return PRECISION_EXTENDED;
+    }
+
+    // direct iteration in quad is far too slow past extended precision
+    return deepest;
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+// choose_iterations:                                                       //
+//   iteration limit for display, either the one set from the command line //
+//   or menu, or the automatic limit. the automatic limit never drops      //
+//   below a floor that grows with the zoom depth                          //
+//////////////////////////////////////////////////////////////////////////////
+int choose_iterations(window_t display){
+
+    if(iteration_limit > 0){
+        return iteration_limit;
+    }
+
+    // number of times the default view's width has been halved
+    double depth = log2(3 / (double)(display.max_x - display.min_x));
+    int floor_limit = DEFAULT_ITERATIONS;
+
+    if(depth > 0){
+        floor_limit += (int)(depth * ITERATIONS_PER_OCTAVE);
+    }
+
+    if(floor_limit > AUTO_MAX_ITERATIONS){
+        floor_limit = AUTO_MAX_ITERATIONS;
+    }
+
+    return auto_iterations > floor_limit ? auto_iterations : floor_limit;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// adapt_iterations:                                                         //
+//   adjust the automatic iteration limit after a frame. cells that escaped //
+//   next to a cell that hit the limit show where the set's edge is, views  //
+//   without an edge are judged by all their escaped cells. when many took  //
+//   more than half the limit, it is cutting points off the edge and is     //
+//   doubled. when almost none took a quarter of it, it is halved. the gap  //
+//   between the two keeps it from flipping back and forth                  //
+///////////////////////////////////////////////////////////////////////////////
+void adapt_iterations(const cell_buffer_t *cells){
+
+    if(iteration_limit > 0 || cells->mu == NULL){
+        return;
+    }
+
+    int limit = cells->frame.iterations;
+    int raised = limit * 2 < AUTO_MAX_ITERATIONS ? limit * 2 : AUTO_MAX_ITERATIONS;
+    int width = cells->width;
+    int height = cells->height;
+
+    // escaped cells and how many took over half and over a quarter of the limit,
+    // over the whole view and along the edge
+    long escaped[2] = {0, 0};
+    long late[2] = {0, 0};
+    long past_quarter[2] = {0, 0};
+
+    int row, col;
+    for(row = 0; row < height; row++){
+        for(col = 0; col < width; col++){
+
+            double mu = cells->mu[row * width + col];
+
+            if(mu == 0){
+                continue;
+            }
+
+            // escaped cell with a neighbour that didn't escape
+            int edge = (row > 0 && cells->mu[(row - 1) * width + col] == 0) ||
+                       (row < height - 1 && cells->mu[(row + 1) * width + col] == 0) ||
+                       (col > 0 && cells->mu[row * width + col - 1] == 0) ||
+                       (col < width - 1 && cells->mu[row * width + col + 1] == 0);
+
+            int k;
+            for(k = 0; k <= edge; k++){
+                escaped[k]++;
+                late[k] += mu > limit / 2;
+                past_quarter[k] += mu > limit / 4;
+            }
+
+        }
+    }
+
+    // nothing escaped, raise the limit only if cells ran out of iterations without a
+    // shortcut proving them inside the set
+    if(escaped[0] == 0){
+        if(frame_counters.exhausted > 0){
+            auto_iterations = raised;
+        }
+        return;
+    }
+
+    int k = escaped[1] > 0;
+
+    if(late[k] > escaped[k] * AUTO_RAISE_FRACTION){
+        auto_iterations = raised;
+    }else if(past_quarter[k] < escaped[k] * AUTO_LOWER_FRACTION){
+        auto_iterations = limit / 2;
+    }
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// choose_boundary:                                                     //
+//   distance on the complex plane under which escaping points of        //
+//   display are drawn as the set, boundary_width of its pixels, or 0    //
+//   when boundaries aren't drawn from distance estimates or the formula //
+//   has none                                                            //
+//////////////////////////////////////////////////////////////////////////
+double choose_boundary(window_t display){
+
+    if(!distance_render || formula_kernels[fractal_formula].distance_kernel_quad == NULL){
+        return 0;
+    }
+
+    coord_t x_spacing = (display.max_x - display.min_x)/display.screen_width;
+    coord_t y_spacing = (display.max_y - display.min_y)/display.screen_height;
+
+    return (double)(x_spacing < y_spacing ? x_spacing : y_spacing) * boundary_width;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////
+// mark_boundary:                                                    //
+//   give points of the frame that escaped closer to the set than    //
+//   its boundary distance the escape value of the set, 0            //
+///////////////////////////////////////////////////////////////////////
+void mark_boundary(const frame_t *frame, double *mu, const double *distance, int n){
+
+    int k;
+    for(k = 0; k < n; k++){
+        if(distance[k] < frame->boundary){
+            mu[k] = 0;
+        }
+    }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compute_span:                                                             //
+//   fill mu with the escape values for the n columns of the given row      //
+//   starting at first_col                                                   //
+///////////////////////////////////////////////////////////////////////////////
+void compute_span(const frame_t *frame, int row, int first_col, int n, double *mu){
+
+    int rows[SPAN_CHUNK], cols[SPAN_CHUNK];
+
+    int start;
+    for(start = 0; start < n; start += SPAN_CHUNK){
+
+        int count = (n - start < SPAN_CHUNK) ? n - start : SPAN_CHUNK;
+        int col;
+
+        for(col = 0; col < count; col++){
+            rows[col] = row;
+            cols[col] = first_col + start + col;
+        }
+
+        compute_points(frame, rows, cols, count, mu + start);
+
+    }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compute_points:                                                           //
+//   fill mu with the escape values for n arbitrary pixels of the frame,    //
+//   iterating in the frame's precision tier                                 //
+///////////////////////////////////////////////////////////////////////////////
+void compute_points(const frame_t *frame, const int *rows, const int *cols, int n, double *mu){
+
+    window_t display = frame->display;
+
+    if(frame->precision == PRECISION_PERTURBATION){
+        perturb_points(frame, rows, cols, n, mu);
+        return;
+    }
+
+    int start;
+    for(start = 0; start < n; start += SPAN_CHUNK){
+
+        int count = (n - start < SPAN_CHUNK) ? n - start : SPAN_CHUNK;
+        int col;
+
+        // points on the complex plane in every tier's type
+        float cr_float[SPAN_CHUNK], ci_float[SPAN_CHUNK];
+        double cr_double[SPAN_CHUNK], ci_double[SPAN_CHUNK];
+        long double cr_extended[SPAN_CHUNK], ci_extended[SPAN_CHUNK];
+        __float128 cr_quad[SPAN_CHUNK], ci_quad[SPAN_CHUNK];
+
+        // distance estimates, only computed when the frame draws boundaries from them
+        double distance[SPAN_CHUNK];
+
+        switch(frame->precision){
+
+            case PRECISION_FLOAT:
+
+                for(col = 0; col < count; col++){
+                    complex_t c = scale(display, rows[start + col], cols[start + col]);
+                    cr_float[col] = c.a;
+                    ci_float[col] = c.b;
+                }
+
+                if(frame->boundary > 0){
+                    escape_engine->distance_kernel_float[frame->formula](cr_float, ci_float, mu + start, distance, count, frame);
+                }else{
+                    escape_engine->kernel_float[frame->formula](cr_float, ci_float, mu + start, count, frame);
+                }
+
+            break;
+
+            case PRECISION_DOUBLE:
+            case PRECISION_PERTURBATION:
+            case PRECISION_AUTO:
+
+                for(col = 0; col < count; col++){
+                    complex_t c = scale(display, rows[start + col], cols[start + col]);
+                    cr_double[col] = c.a;
+                    ci_double[col] = c.b;
+                }
+
+                if(frame->boundary > 0){
+                    escape_engine->distance_kernel[frame->formula](cr_double, ci_double, mu + start, distance, count, frame);
+                }else{
+                    escape_engine->kernel[frame->formula](cr_double, ci_double, mu + start, count, frame);
+                }
+
+            break;
+
+            case PRECISION_EXTENDED:
+
+                for(col = 0; col < count; col++){
+                    complex_t c = scale(display, rows[start + col], cols[start + col]);
+                    cr_extended[col] = c.a;
+                    ci_extended[col] = c.b;
+                }
+
+                if(frame->boundary > 0){
+                    formula_kernels[frame->formula].distance_kernel_extended(cr_extended, ci_extended, mu + start, distance, count, frame);
+                }else{
+                    formula_kernels[frame->formula].kernel_extended(cr_extended, ci_extended, mu + start, count, frame);
+                }
+
+            break;
+
+            case PRECISION_QUAD:
+
+                for(col = 0; col < count; col++){
+                    scale_quad(display, rows[start + col], cols[start + col], &cr_quad[col], &ci_quad[col]);
+                }
+
+                if(frame->boundary > 0){
+                    formula_kernels[frame->formula].distance_kernel_quad(cr_quad, ci_quad, mu + start, distance, count, frame);
+                }else{
+                    formula_kernels[frame->formula].kernel_quad(cr_quad, ci_quad, mu + start, count, frame);
+                }
+
+            break;
+
+        }
+
+        if(frame->boundary > 0){
+            mark_boundary(frame, mu + start, distance, count);
+        }
+
+    }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compute_offsets:                                                          //
+//   fill mu with the escape values for n points given by their offset      //
+//   (dx, dy) from the center of the frame's window, which don't have to    //
+//   fall on pixels, iterating in the frame's precision tier                 //
+///////////////////////////////////////////////////////////////////////////////
+void compute_offsets(const frame_t *frame, const double *dx, const double *dy, int n, double *mu){
+
+    window_t display = frame->display;
+
+    if(frame->precision == PRECISION_PERTURBATION){
+        perturb_offsets(frame, dx, dy, n, mu);
+        return;
+    }
+
+    coord_t center_x = (display.min_x + display.max_x) / 2;
+    coord_t center_y = (display.min_y + display.max_y) / 2;
+
+    int start;
+    for(start = 0; start < n; start += SPAN_CHUNK){
+
+        int count = (n - start < SPAN_CHUNK) ? n - start : SPAN_CHUNK;
+        int k;
+
+        // points on the complex plane in every tier's type
+        float cr_float[SPAN_CHUNK], ci_float[SPAN_CHUNK];
+        double cr_double[SPAN_CHUNK], ci_double[SPAN_CHUNK];
+        long double cr_extended[SPAN_CHUNK], ci_extended[SPAN_CHUNK];
+        __float128 cr_quad[SPAN_CHUNK], ci_quad[SPAN_CHUNK];
+
+        // distance estimates, only computed when the frame draws boundaries from them
+        double distance[SPAN_CHUNK];
+
+        switch(frame->precision){
+
+            case PRECISION_FLOAT:
+
+                for(k = 0; k < count; k++){
+                    cr_float[k] = (long double)center_x + dx[start + k];
+                    ci_float[k] = (long double)center_y + dy[start + k];
+                }
+
+                if(frame->boundary > 0){
+                    escape_engine->distance_kernel_float[frame->formula](cr_float, ci_float, mu + start, distance, count, frame);
+                }else{
+                    escape_engine->kernel_float[frame->formula](cr_float, ci_float, mu + start, count, frame);
+                }
+
+            break;
+
+            case PRECISION_DOUBLE:
+            case PRECISION_PERTURBATION:
+            case PRECISION_AUTO:
+
+                for(k = 0; k < count; k++){
+                    cr_double[k] = (long double)center_x + dx[start + k];
+                    ci_double[k] = (long double)center_y + dy[start + k];
+                }
+
+                if(frame->boundary > 0){
+                    escape_engine->distance_kernel[frame->formula](cr_double, ci_double, mu + start, distance, count, frame);
+                }else{
+                    escape_engine->kernel[frame->formula](cr_double, ci_double, mu + start, count, frame);
+                }
+
+            break;
+
+            case PRECISION_EXTENDED:
+
+                for(k = 0; k < count; k++){
+                    cr_extended[k] = (long double)center_x + dx[start + k];
+                    ci_extended[k] = (long double)center_y + dy[start + k];
+                }
+
+                if(frame->boundary > 0){
+                    formula_kernels[frame->formula].distance_kernel_extended(cr_extended, ci_extended, mu + start, distance, count, frame);
+                }else{
+                    formula_kernels[frame->formula].kernel_extended(cr_extended, ci_extended, mu + start, count, frame);
+                }
+
+            break;
+
+            case PRECISION_QUAD:
+
+                for(k = 0; k < count; k++){
+                    cr_quad[k] = center_x + dx[start + k];
+                    ci_quad[k] = center_y + dy[start + k];
+                }
+
+                if(frame->boundary > 0){
+                    formula_kernels[frame->formula].distance_kernel_quad(cr_quad, ci_quad, mu + start, distance, count, frame);
+                }else{
+                    formula_kernels[frame->formula].kernel_quad(cr_quad, ci_quad, mu + start, count, frame);
+                }
+
+            break;
+
+        }
+
+        if(frame->boundary > 0){
+            mark_boundary(frame, mu + start, distance, count);
+        }
+
+    }
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// prepare_frame:                                                     //
+//   pick the formula, precision and iteration limit for display and  //
+//   compute the reference orbit when the frame is rendered with      //
+//   perturbation. resets the shortcut counters                       //
+////////////////////////////////////////////////////////////////////////
+void prepare_frame(frame_t *frame, window_t display){
+
+    // shortcut counters cover one frame
+    memset(&frame_counters, 0, sizeof(frame_counters));
+
+    prepare_frame_iterations(frame, display, choose_iterations(display));
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+// prepare_frame_iterations:                                             //
+//   prepare_frame with the iteration limit given instead of read from   //
+//   the settings, for callers rendering several limits at the same time //
+//   and leaves the shortcut counters, which other threads add to        //
+///////////////////////////////////////////////////////////////////////////
+void prepare_frame_iterations(frame_t *frame, window_t display, int iterations){
+
+    frame->display = display;
+    frame->precision = choose_precision(display);
+    frame->iterations = iterations;
+    frame->boundary = choose_boundary(display);
+    frame->reference = NULL;
+    set_frame_formula(frame);
+    set_frame_grid(frame);
+
+    // reference at the center of the window, series approximation shared by all pixels
+    if(frame->precision == PRECISION_PERTURBATION){
+        frame->reference = compute_reference_orbit(display, frame->iterations, display.screen_height / 2, display.screen_width / 2, TRUE);
+    }
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// set_frame_formula:                                                   //
+//   take the formula being drawn. the julia constant is left 0 for     //
+//   the others so it never splits their cached tiles. rectangles are   //
+//   only filled for sets known to be connected and full: mandelbrot,   //
+//   multibrot, and julia sets whose constant stays in the mandelbrot   //
+//   set for the frame's iteration limit. the burning ship isn't, and   //
+//   neither is a set thickened by boundaries, so frame's boundary      //
+//   has to be set first                                                //
+//////////////////////////////////////////////////////////////////////////
+void set_frame_formula(frame_t *frame){
+
+    frame->formula = fractal_formula;
+    frame->julia_r = fractal_formula == JULIA ? julia_r : 0;
+    frame->julia_i = fractal_formula == JULIA ? julia_i : 0;
+
+    if(fractal_formula == JULIA){
+
+        complex_t constant;
+        constant.a = (long double)julia_r;
+        constant.b = (long double)julia_i;
+        frame->fill_interiors = is_in_set(constant, frame->iterations) == 0;
+
+    }else{
+
+        frame->fill_interiors = fractal_formula != BURNING_SHIP;
+
+    }
+
+    // points near the set count as in it, and can ring holes that escape
+    if(frame->boundary > 0){
+        frame->fill_interiors = FALSE;
+    }
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////
+// set_frame_grid:                                                //
+//   find the grid index of the frame's top left cell. rows count //
+//   down from the real axis, like the rows of the window         //
+////////////////////////////////////////////////////////////////////
+void set_frame_grid(frame_t *frame){
+
+    window_t display = frame->display;
+    window_t snapped = display;
+    snap_window(&snapped);
+
+    coord_t x_cursor_units = (display.max_x - display.min_x)/display.screen_width;
+    coord_t y_cursor_units = (display.max_y - display.min_y)/display.screen_height;
+
+    frame->grid_col = round_coord(display.min_x / x_cursor_units);
+    frame->grid_row = round_coord(-display.max_y / y_cursor_units);
+
+    // cells off the snapped grid aren't exact multiples of the spacing and can't be shared
+    frame->cacheable = snapped.min_x == display.min_x && snapped.max_x == display.max_x &&
+                       snapped.min_y == display.min_y && snapped.max_y == display.max_y;
+
+}
+
+
+
+//////////////////////////////////////////////
+// release_frame:                           //
+//   free what prepare_frame allocated      //
+//////////////////////////////////////////////
+void release_frame(frame_t *frame){
+
+    if(frame->reference != NULL){
+        free_reference_orbit(frame->reference);
+        frame->reference = NULL;
+    }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compute_reference_orbit:                                                  //
+//   iterate the point at pixel (ref_row, ref_col) in quad precision and     //
+//   store its orbit. with use_series, also find how many iterations every  //
+//   pixel of display can skip with a third order series approximation     //
+///////////////////////////////////////////////////////////////////////////////
+reference_orbit_t *compute_reference_orbit(window_t display, int iterations, int ref_row, int ref_col, int use_series){
+
+    reference_orbit_t *orbit = malloc(sizeof(reference_orbit_t));
+
+    if(orbit != NULL){
+        orbit->zr = malloc((iterations + 1) * sizeof(double));
+        orbit->zi = malloc((iterations + 1) * sizeof(double));
+    }
+
+    if(orbit == NULL || orbit->zr == NULL || orbit->zi == NULL){
+        printf("error allocating memory for reference orbit\n");
+        exit(1);
+    }
+
+    orbit->iterations = iterations;
+    orbit->ref_row = ref_row;
+    orbit->ref_col = ref_col;
+    orbit->dx = (display.max_x - display.min_x)/display.screen_width;
+    orbit->dy = (display.max_y - display.min_y)/display.screen_height;
+
+    __float128 cr, ci;
+    scale_quad(display, ref_row, ref_col, &cr, &ci);
+
+    // iterate reference until it escapes, its orbit ends there
+    __float128 zr = 0;
+    __float128 zi = 0;
+    orbit->zr[0] = 0;
+    orbit->zi[0] = 0;
+
+    int n;
+    for(n = 1; n <= iterations; n++){
+
+        __float128 t = zr * zr - zi * zi + cr;
+        zi = 2 * zr * zi + ci;
+        zr = t;
+
+        orbit->zr[n] = zr;
+        orbit->zi[n] = zi;
+
+        if(zr * zr + zi * zi > 4){
+            break;
+        }
+
+    }
+
+    orbit->length = n > iterations ? iterations : n;
+
+    // without series, pixels start from delta_0 = 0 at any distance
+    orbit->skip = 0;
+    orbit->radius = HUGE_VAL;
+    orbit->a[0] = orbit->a[1] = 0;
+    orbit->b[0] = orbit->b[1] = 0;
+    orbit->c[0] = orbit->c[1] = 0;
+
+    if(!use_series){
+        return orbit;
+    }
+
+    // largest delta from the reference over the whole window, with a quarter of
+    // the window to spare on each side so the orbit can be kept while panning
+    double far_col = ref_col > display.screen_width - ref_col ? ref_col : display.screen_width - ref_col;
+    double far_row = ref_row > display.screen_height - ref_row ? ref_row : display.screen_height - ref_row;
+    far_col += display.screen_width / 4;
+    far_row += display.screen_height / 4;
+    double delta = hypot(far_col * orbit->dx, far_row * orbit->dy);
+    orbit->radius = delta;
+
+    // coefficients for delta_n, starting from delta_0 = 0
+    double a[2] = {0, 0};
+    double b[2] = {0, 0};
+    double c[2] = {0, 0};
+
+    // stop one short of the reference's escape so every pixel still has iterations left
+    for(n = 0; n < orbit->length - 1; n++){
+
+        double Zr = orbit->zr[n];
+        double Zi = orbit->zi[n];
+
+        // a' = 2Za + 1, b' = 2Zb + a^2, c' = 2Zc + 2ab
+        double next_a[2], next_b[2], next_c[2];
+        next_a[0] = 2 * (Zr * a[0] - Zi * a[1]) + 1;
+        next_a[1] = 2 * (Zr * a[1] + Zi * a[0]);
+        next_b[0] = 2 * (Zr * b[0] - Zi * b[1]) + (a[0] * a[0] - a[1] * a[1]);
+        next_b[1] = 2 * (Zr * b[1] + Zi * b[0]) + (2 * a[0] * a[1]);
+        next_c[0] = 2 * (Zr * c[0] - Zi * c[1]) + 2 * (a[0] * b[0] - a[1] * b[1]);
+        next_c[1] = 2 * (Zr * c[1] + Zi * c[0]) + 2 * (a[0] * b[1] + a[1] * b[0]);
+
+        // stop once the third order term is no longer negligible against the first
+        double first = hypot(next_a[0], next_a[1]) * delta;
+        double third = hypot(next_c[0], next_c[1]) * delta * delta * delta;
+
+        if(!(third <= SERIES_TOLERANCE * first)){
+            break;
+        }
+
+        memcpy(a, next_a, sizeof(a));
+        memcpy(b, next_b, sizeof(b));
+        memcpy(c, next_c, sizeof(c));
+
+    }
+
+    orbit->skip = n;
+    memcpy(orbit->a, a, sizeof(a));
+    memcpy(orbit->b, b, sizeof(b));
+    memcpy(orbit->c, c, sizeof(c));
+
+    return orbit;
+
+}
+
+
+
+///////////////////////////////////////////
+// free_reference_orbit:                 //
+//   free memory used by a reference orbit //
+///////////////////////////////////////////
+void free_reference_orbit(reference_orbit_t *orbit){
+
+    free(orbit->zr);
+    free(orbit->zi);
+    free(orbit);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// perturb_point:                                                            //
+//   iterate the point dc away from the reference as a delta from its orbit //
+//   and store its escape value in mu, and its distance estimate unless     //
+//   distance is NULL. returns TRUE if the point glitched and needs a       //
+//   different reference. the iterations run are added to iterated either   //
+//   way                                                                     //
+///////////////////////////////////////////////////////////////////////////////
+int perturb_point(const reference_orbit_t *orbit, double dcr, double dci, double *mu, double *distance, long *iterated){
+
+    int n = orbit->skip;
+
+    // start from the series approximation of delta at the skipped iteration
+    double dc2r = dcr * dcr - dci * dci;
+    double dc2i = 2 * dcr * dci;
+    double dc3r = dc2r * dcr - dc2i * dci;
+    double dc3i = dc2r * dci + dc2i * dcr;
+
+    double dr = (orbit->a[0] * dcr - orbit->a[1] * dci)
+              + (orbit->b[0] * dc2r - orbit->b[1] * dc2i)
+              + (orbit->c[0] * dc3r - orbit->c[1] * dc3i);
+    double di = (orbit->a[0] * dci + orbit->a[1] * dcr)
+              + (orbit->b[0] * dc2i + orbit->b[1] * dc2r)
+              + (orbit->c[0] * dc3i + orbit->c[1] * dc3r);
+
+    // point escaped before the skipped iterations, series doesn't hold for it
+    double zr = orbit->zr[n] + dr;
+    double zi = orbit->zi[n] + di;
+
+    if(n > 0 && zr * zr + zi * zi > 4){
+        return TRUE;
+    }
+
+    // the series coefficients are the derivatives of delta, so dz/dc at the skipped
+    // iteration is a + 2b*dc + 3c*dc^2, and it is tracked on the full z from there
+    double der_r = orbit->a[0] + 2 * (orbit->b[0] * dcr - orbit->b[1] * dci) + 3 * (orbit->c[0] * dc2r - orbit->c[1] * dc2i);
+    double der_i = orbit->a[1] + 2 * (orbit->b[0] * dci + orbit->b[1] * dcr) + 3 * (orbit->c[0] * dc2i + orbit->c[1] * dc2r);
+
+    // i is the iteration number matching the direct kernels
+    int i;
+    for(i = n + 1; i < orbit->iterations; i++){
+
+        // reference ran out before this point escaped
+        if(i > orbit->length){
+            *iterated += i - n;
+            return TRUE;
+        }
+
+        if(distance != NULL){
+            double s = 2 * (zr * der_r - zi * der_i) + 1;
+            der_i = 2 * (zr * der_i + zi * der_r);
+            der_r = s;
+        }
+
+        // delta' = 2 Z delta + delta^2 + dc
+        double Zr = orbit->zr[i - 1];
+        double Zi = orbit->zi[i - 1];
+        double t = 2 * (Zr * dr - Zi * di) + (dr * dr - di * di) + dcr;
+        di = 2 * (Zr * di + Zi * dr) + 2 * dr * di + dci;
+        dr = t;
+
+        zr = orbit->zr[i] + dr;
+        zi = orbit->zi[i] + di;
+
+        double mag = zr * zr + zi * zi;
+
+        if(mag > 4){
+            break;
+        }
+
+        // precision loss when the full orbit passes much closer to 0 than the reference
+        double ref_mag = orbit->zr[i] * orbit->zr[i] + orbit->zi[i] * orbit->zi[i];
+        if(mag < GLITCH_TOLERANCE * ref_mag){
+            *iterated += i - n;
+            return TRUE;
+        }
+
+    }
+
+    *iterated += i - n;
+
+    // finish like the direct kernels, c itself is only needed for the final iterations
+    double cr = orbit->zr[1] + dcr;
+    double ci = orbit->zi[1] + dci;
+
+    *mu = smooth_escape_mandelbrot(zr, zi, cr, ci, i, orbit->iterations);
+
+    if(distance != NULL){
+        *distance = smooth_distance_mandelbrot(zr, zi, der_r, der_i, cr, ci, i, orbit->iterations);
+    }
+
+    return FALSE;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// perturb_points:                                                           //
+//   compute_points for perturbation frames. glitched pixels are moved onto //
+//   a new reference at one of them, and after MAX_REBASES attempts         //
+//   iterated directly in quad                                               //
+///////////////////////////////////////////////////////////////////////////////
+void perturb_points(const frame_t *frame, const int *rows, const int *cols, int n, double *mu){
+
+    const reference_orbit_t *orbit = frame->reference;
+    reference_orbit_t *rebased = NULL;
+
+    // points still left to compute
+    int *pending = malloc(n * sizeof(int));
+
+    if(pending == NULL){
+        printf("error allocating memory for glitch list\n");
+        exit(1);
+    }
+
+    int n_pending = n;
+    int k;
+    for(k = 0; k < n; k++){
+        pending[k] = k;
+    }
+
+    // perturbation has no interior shortcuts, every point that didn't escape ran out
+    frame_counters_t counts = {0};
+
+    int attempt;
+    for(attempt = 0; n_pending > 0 && attempt <= MAX_REBASES; attempt++){
+
+        // after the first pass, rebase onto the first glitched pixel
+        if(attempt > 0){
+
+            if(rebased != NULL){
+                free_reference_orbit(rebased);
+            }
+
+            rebased = compute_reference_orbit(frame->display, frame->iterations, rows[pending[0]], cols[pending[0]], FALSE);
+            orbit = rebased;
+
+        }
+
+        int glitched = 0;
+        for(k = 0; k < n_pending; k++){
+
+            int point = pending[k];
+            double dcr = (cols[point] - orbit->ref_col) * orbit->dx;
+            double dci = -(rows[point] - orbit->ref_row) * orbit->dy;
+            double distance;
+
+            if(perturb_point(orbit, dcr, dci, &mu[point], frame->boundary > 0 ? &distance : NULL, &counts.iterations)){
+                pending[glitched++] = point;
+                continue;
+            }
+
+            if(mu[point] == 0){
+                counts.exhausted++;
+            }else{
+                counts.escaped++;
+            }
+
+            if(frame->boundary > 0){
+                mark_boundary(frame, &mu[point], &distance, 1);
+            }
+
+        }
+
+        n_pending = glitched;
+
+    }
+
+    // give up on perturbation for whatever is left
+    for(k = 0; k < n_pending; k++){
+
+        __float128 cr, ci;
+        scale_quad(frame->display, rows[pending[k]], cols[pending[k]], &cr, &ci);
+
+        if(frame->boundary > 0){
+            double distance;
+            distance_kernel_quad_mandelbrot(&cr, &ci, &mu[pending[k]], &distance, 1, frame);
+            mark_boundary(frame, &mu[pending[k]], &distance, 1);
+        }else{
+            escape_kernel_quad_mandelbrot(&cr, &ci, &mu[pending[k]], 1, frame);
+        }
+
+    }
+
+    if(rebased != NULL){
+        free_reference_orbit(rebased);
+    }
+
+    add_frame_counters(&counts);
+    free(pending);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// perturb_offsets:                                                          //
+//   compute_offsets for frames rendered with perturbation. like            //
+//   perturb_points, glitched points are moved to a reference at the pixel  //
+//   nearest the first of them, and iterated in quad if they still glitch   //
+///////////////////////////////////////////////////////////////////////////////
+void perturb_offsets(const frame_t *frame, const double *dx, const double *dy, int n, double *mu){
+
+    window_t display = frame->display;
+    const reference_orbit_t *orbit = frame->reference;
+    reference_orbit_t *rebased = NULL;
+
+    // window center in pixels, offsets are measured from it
+    double center_col = display.screen_width / 2.0;
+    double center_row = display.screen_height / 2.0;
+
+    // points still left to compute
+    int *pending = malloc(n * sizeof(int));
+
+    if(pending == NULL){
+        printf("error allocating memory for glitch list\n");
+        exit(1);
+    }
+
+    int n_pending = n;
+    int k;
+    for(k = 0; k < n; k++){
+        pending[k] = k;
+    }
+
+    frame_counters_t counts = {0};
+
+    int attempt;
+    for(attempt = 0; n_pending > 0 && attempt <= MAX_REBASES; attempt++){
+
+        if(attempt > 0){
+
+            if(rebased != NULL){
+                free_reference_orbit(rebased);
+            }
+
+            int col = (int)lround(center_col + dx[pending[0]] / orbit->dx);
+            int row = (int)lround(center_row - dy[pending[0]] / orbit->dy);
+            rebased = compute_reference_orbit(display, frame->iterations, row, col, FALSE);
+            orbit = rebased;
+
+        }
+
+        // center relative to the reference
+        double ref_r = (center_col - orbit->ref_col) * orbit->dx;
+        double ref_i = (orbit->ref_row - center_row) * orbit->dy;
+
+        int glitched = 0;
+        for(k = 0; k < n_pending; k++){
+
+            int point = pending[k];
+            double distance;
+
+            if(perturb_point(orbit, ref_r + dx[point], ref_i + dy[point], &mu[point],
+                             frame->boundary > 0 ? &distance : NULL, &counts.iterations)){
+                pending[glitched++] = point;
+                continue;
+            }
+
+            if(mu[point] == 0){
+                counts.exhausted++;
+            }else{
+                counts.escaped++;
+            }
+
+            if(frame->boundary > 0){
+                mark_boundary(frame, &mu[point], &distance, 1);
+            }
+
+        }
+
+        n_pending = glitched;
+
+    }
+
+    // give up on perturbation for whatever is left
+    coord_t center_x = (display.min_x + display.max_x) / 2;
+    coord_t center_y = (display.min_y + display.max_y) / 2;
+
+    for(k = 0; k < n_pending; k++){
+
+        __float128 cr = center_x + dx[pending[k]];
+        __float128 ci = center_y + dy[pending[k]];
+
+        if(frame->boundary > 0){
+            double distance;
+            distance_kernel_quad_mandelbrot(&cr, &ci, &mu[pending[k]], &distance, 1, frame);
+            mark_boundary(frame, &mu[pending[k]], &distance, 1);
+        }else{
+            escape_kernel_quad_mandelbrot(&cr, &ci, &mu[pending[k]], 1, frame);
+        }
+
+    }
+
+    if(rebased != NULL){
+        free_reference_orbit(rebased);
+    }
+
+    add_frame_counters(&counts);
+    free(pending);
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// compute_cells:                                                       //
+//   fill the cell buffer with escape values for every cell of display //
+//   using the render pool, resizing the buffer if the view has changed //
+//////////////////////////////////////////////////////////////////////////
+void compute_cells(cell_buffer_t *cells, window_t display){
+
+    // panning by whole cells only needs the cells that scrolled in
+    if(shift_cells(cells, display)){
+        return;
+    }
+
+    reset_cells(cells, display);
+    compute_cell_area(cells, 0, 0, cells->height, cells->width);
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////
+// reset_cells:                                                   //
+//   size the cell buffer for display and prepare its frame, no  //
+//   cell is computed yet                                         //
+////////////////////////////////////////////////////////////////////
+void reset_cells(cell_buffer_t *cells, window_t display){
+
+    // grow buffer when the terminal gets bigger
+    if((size_t)display.screen_width * display.screen_height > cells->capacity){
+
+        free(cells->mu);
+        free(cells->known);
+        cells->capacity = (size_t)display.screen_width * display.screen_height;
+        cells->mu = malloc(cells->capacity * sizeof(double));
+        cells->known = malloc(cells->capacity);
+
+        if(cells->mu == NULL || cells->known == NULL){
+            printf("error allocating memory for cell buffer\n");
+            exit(1);
+        }
+
+    }
+
+    release_frame(&cells->frame);
+    prepare_frame(&cells->frame, display);
+
+    cells->width = display.screen_width;
+    cells->height = display.screen_height;
+    cells->seeded = FALSE;
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// sample_row:                                                        //
+//   compute the cells of one sampled row of a progressive pass that //
+//   earlier passes haven't, called by workers                       //
+////////////////////////////////////////////////////////////////////////
+void sample_row(void *context, int index){
+
+    progressive_pass_t *pass = context;
+    cell_buffer_t *cells = pass->cells;
+
+    int row = index * pass->step;
+    int rows[SPAN_CHUNK], cols[SPAN_CHUNK];
+    double mu[SPAN_CHUNK];
+    int n = 0;
+
+    int col, k;
+    for(col = 0; col < cells->width; col += pass->step){
+
+        if(!cells->known[row * cells->width + col]){
+            rows[n] = row;
+            cols[n] = col;
+            n++;
+        }
+
+        // compute a chunk once it is full or the row is done
+        if(n == SPAN_CHUNK || (n > 0 && col + pass->step >= cells->width)){
+
+            compute_points(&cells->frame, rows, cols, n, mu);
+
+            for(k = 0; k < n; k++){
+                cells->mu[row * cells->width + cols[k]] = mu[k];
+                cells->known[row * cells->width + cols[k]] = TRUE;
+            }
+
+            n = 0;
+
+        }
+
+    }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// shift_cells:                                                              //
+//   when display is the buffer's window moved by whole cells of the same   //
+//   snapped grid, move the cells still visible to their new place and      //
+//   compute only the rows and columns that scrolled in. perturbation frames //
+//   keep their reference orbit while its series covers the new window.     //
+//   returns FALSE when the whole buffer needs computing                     //
+///////////////////////////////////////////////////////////////////////////////
+int shift_cells(cell_buffer_t *cells, window_t display){
+
+    window_t previous = cells->frame.display;
+    int width = display.screen_width;
+    int height = display.screen_height;
+
+    if(cells->mu == NULL || width != cells->width || height != cells->height){
+        return FALSE;
+    }
+
+    // cells only keep their exact value on the snapped grid
+    frame_t moved = cells->frame;
+    moved.display = display;
+    set_frame_formula(&moved);
+    set_frame_grid(&moved);
+
+    if(!moved.cacheable){
+        return FALSE;
+    }
+
+    // same formula, spacing, precision, iteration limit and boundary width
+    if(moved.formula != cells->frame.formula ||
+       moved.julia_r != cells->frame.julia_r || moved.julia_i != cells->frame.julia_i ||
+       display.max_x - display.min_x != previous.max_x - previous.min_x ||
+       display.max_y - display.min_y != previous.max_y - previous.min_y ||
+       choose_precision(display) != cells->frame.precision ||
+       choose_iterations(display) != cells->frame.iterations ||
+       choose_boundary(display) != cells->frame.boundary){
+        return FALSE;
+    }
+
+    // shift in cells, old cell (row + row_shift, col + col_shift) is now at (row, col)
+    coord_t x_cursor_units = (display.max_x - display.min_x)/width;
+    coord_t y_cursor_units = (display.max_y - display.min_y)/height;
+    coord_t col_shift = (display.min_x - previous.min_x) / x_cursor_units;
+    coord_t row_shift = (previous.max_y - display.max_y) / y_cursor_units;
+
+    if(col_shift != round_coord(col_shift) || row_shift != round_coord(row_shift) ||
+       col_shift <= -width || col_shift >= width || row_shift <= -height || row_shift >= height){
+        return FALSE;
+    }
+
+    int dc = (int)col_shift;
+    int dr = (int)row_shift;
+
+    // the reference moves with the grid
+    reference_orbit_t *reference = cells->frame.reference;
+
+    if(reference != NULL){
+
+        double ref_row = reference->ref_row - dr;
+        double ref_col = reference->ref_col - dc;
+        double far_col = fabs(ref_col) > fabs(width - ref_col) ? fabs(ref_col) : fabs(width - ref_col);
+        double far_row = fabs(ref_row) > fabs(height - ref_row) ? fabs(ref_row) : fabs(height - ref_row);
+
+        if(hypot(far_col * reference->dx, far_row * reference->dy) > reference->radius){
+            return FALSE;
+        }
+
+        reference->ref_row = ref_row;
+        reference->ref_col = ref_col;
+
+    }
+
+    cells->frame.display = display;
+    set_frame_grid(&cells->frame);
+    memset(&frame_counters, 0, sizeof(frame_counters));
+
+    // rows and columns of the new window that were already visible
+    int kept_first_row = dr < 0 ? -dr : 0;
+    int kept_rows = height - abs(dr);
+    int kept_first_col = dc < 0 ? -dc : 0;
+    int kept_cols = width - abs(dc);
+
+    // go through rows in the direction that doesn't overwrite rows still to be moved
+    int k;
+    for(k = 0; k < kept_rows; k++){
+
+        int row = dr > 0 ? kept_first_row + k : kept_first_row + kept_rows - 1 - k;
+        memmove(cells->mu + row * width + kept_first_col,
+                cells->mu + (row + dr) * width + kept_first_col + dc,
+                kept_cols * sizeof(double));
+
+    }
+
+    // rows that scrolled in, then columns that scrolled in beside the kept rows
+    if(dr != 0){
+        compute_cell_area(cells, dr < 0 ? 0 : height - dr, 0, abs(dr), width);
+    }
+
+    if(dc != 0){
+        compute_cell_area(cells, kept_first_row, dc < 0 ? 0 : width - dc, kept_rows, abs(dc));
+    }
+
+    return TRUE;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////
+// compute_cell_area:                                                //
+//   compute a rectangle of the cell buffer on the render pool      //
+///////////////////////////////////////////////////////////////////////
+void compute_cell_area(cell_buffer_t *cells, int first_row, int first_col, int rows, int cols){
+
+    init_tile_area(&cells->area, &cells->frame, first_row, first_col, rows, cols);
+    render_pool_run(get_render_pool(), cell_tile, cells, cells->area.tiles_down * cells->area.tiles_across);
+
+}
+
+
+
+//////////////////////////////////////////////////////////////
+// cell_tile:                                               //
+//   compute one tile of the cell buffer, called by workers //
+//////////////////////////////////////////////////////////////
+void cell_tile(void *context, int tile){
+
+    cell_buffer_t *cells = context;
+
+    int corner_row, corner_col;
+    rect_t clip;
+    get_area_tile(&cells->area, tile, &corner_row, &corner_col, &clip);
+
+    compute_area_tile(&cells->frame, &cells->area, tile,
+                      cells->mu + clip.top * cells->width + clip.left, cells->width,
+                      cells->seeded ? cells->known + clip.top * cells->width + clip.left : NULL);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compute_tile:                                                             //
+//   fill mu (rows apart by stride) with the escape values of a tile of the //
+//   frame, either pixel by pixel in strict mode or by rectangle subdivision //
+//   when given, known (rows TILE_WIDTH apart) marks the pixels mu already  //
+//   holds, it is updated with the pixels computed                           //
+///////////////////////////////////////////////////////////////////////////////
+void compute_tile(const frame_t *frame, int first_row, int first_col, int rows, int cols, double *mu, int stride,
+                  unsigned char *known){
+
+    int row;
+
+    tile_region_t region;
+    region.frame = frame;
+    region.first_row = first_row;
+    region.first_col = first_col;
+    region.mu = mu;
+    region.stride = stride;
+    region.n_queued = 0;
+
+    memset(region.known, 0, sizeof(region.known));
+
+    if(known != NULL){
+        for(row = 0; row < rows; row++){
+            memcpy(region.known + row * TILE_WIDTH, known + row * TILE_WIDTH, cols);
+        }
+    }
+
+    // sets that may be disconnected or have holes get every pixel computed too
+    if(strict_render || !frame->fill_interiors){
+
+        for(row = 0; row < rows; row++){
+            queue_region_run(&region, row, 0, cols - 1);
+        }
+
+        compute_queued(&region);
+
+    }else{
+
+        subdivide_tile(&region, rows, cols);
+
+    }
+
+    if(known != NULL){
+        for(row = 0; row < rows; row++){
+            memcpy(known + row * TILE_WIDTH, region.known + row * TILE_WIDTH, cols);
+        }
+    }
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// subdivide_tile:                                                      //
+//   fill the pixels of the region that aren't known by subdivision of //
+//   the whole tile                                                     //
+//////////////////////////////////////////////////////////////////////////
+void subdivide_tile(tile_region_t *region, int rows, int cols){
+
+    // rectangles at the current and next depth. every rectangle covers at
+    // least one pixel gap that no other rectangle at its depth does
+    rect_t rects[2][TILE_HEIGHT * TILE_WIDTH];
+    int current = 0;
+    int n_rects = 1;
+    int r;
+
+    rects[0][0] = (rect_t){0, 0, rows - 1, cols - 1};
+
+    // go through the subdivision one depth at a time so the borders of all
+    // rectangles at a depth are computed in a single batch, small batches
+    // would leave most vector lanes empty
+    while(n_rects > 0){
+
+        for(r = 0; r < n_rects; r++){
+            queue_border(region, rects[current][r]);
+        }
+
+        compute_queued(region);
+
+        int n_next = 0;
+        for(r = 0; r < n_rects; r++){
+            n_next += subdivide_rect(region, rects[current][r], &rects[!current][n_next]);
+        }
+
+        current = !current;
+        n_rects = n_next;
+
+    }
+
+    // interiors of the last rectangles too small to split
+    compute_queued(region);
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////////
+// subdivide_rect:                                                              //
+//   Mariani-Silver subdivision step for a rectangle whose border is known. if  //
+//   every border pixel has the same mu the interior is filled with it, small   //
+//   rectangles have their interior queued, otherwise the rectangle is split    //
+//   in two along its longer side. returns the number of halves stored. only    //
+//   used for sets that are connected and full, where a border entirely in the  //
+//   set can't enclose anything outside of it                                   //
+//////////////////////////////////////////////////////////////////////////////////
+int subdivide_rect(tile_region_t *region, rect_t rect, rect_t *halves){
+
+    int top = rect.top, left = rect.left, bottom = rect.bottom, right = rect.right;
+    int row, col;
+
+    // check whether the whole border has the same escape value
+    double border = region->mu[top * region->stride + left];
+    int uniform = TRUE;
+
+    for(col = left; col <= right && uniform; col++){
+        uniform = region->mu[top * region->stride + col] == border
+               && region->mu[bottom * region->stride + col] == border;
+    }
+
+    for(row = top + 1; row < bottom && uniform; row++){
+        uniform = region->mu[row * region->stride + left] == border
+               && region->mu[row * region->stride + right] == border;
+    }
+
+    if(uniform){
+
+        long filled = 0;
+
+        for(row = top + 1; row < bottom; row++){
+            for(col = left + 1; col < right; col++){
+
+                if(!region->known[row * TILE_WIDTH + col]){
+                    region->mu[row * region->stride + col] = border;
+                    region->known[row * TILE_WIDTH + col] = TRUE;
+                    filled++;
+                }
+
+            }
+        }
+
+        __atomic_fetch_add(&frame_counters.filled, filled, __ATOMIC_RELAXED);
+        return 0;
+
+    }
+
+    // too small to be worth splitting, compute the rest of the interior
+    if(bottom - top < 3 || right - left < 3){
+
+        for(row = top + 1; row < bottom; row++){
+            queue_region_run(region, row, left + 1, right - 1);
+        }
+
+        return 0;
+
+    }
+
+    // split along the longer side, the halves share the middle row or column
+    if(right - left >= bottom - top){
+
+        int middle = (left + right) / 2;
+        halves[0] = (rect_t){top, left, bottom, middle};
+        halves[1] = (rect_t){top, middle, bottom, right};
+
+    }else{
+
+        int middle = (top + bottom) / 2;
+        halves[0] = (rect_t){top, left, middle, right};
+        halves[1] = (rect_t){middle, left, bottom, right};
+
+    }
+
+    return 2;
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// queue_border:                                        //
+//   queue the border pixels of rect that aren't known  //
+//////////////////////////////////////////////////////////
+void queue_border(tile_region_t *region, rect_t rect){
+
+    int row;
+
+    queue_region_run(region, rect.top, rect.left, rect.right);
+    queue_region_run(region, rect.bottom, rect.left, rect.right);
+
+    for(row = rect.top + 1; row < rect.bottom; row++){
+        queue_region_run(region, row, rect.left, rect.left);
+        queue_region_run(region, row, rect.right, rect.right);
+    }
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////
+// queue_region_run:                                                   //
+//   queue the pixels between left and right (inclusive) of a row of   //
+//   the region that aren't known yet                                  //
+/////////////////////////////////////////////////////////////////////////
+void queue_region_run(tile_region_t *region, int row, int left, int right){
+
+    int col;
+    for(col = left; col <= right; col++){
+
+        if(!region->known[row * TILE_WIDTH + col]){
+            region->known[row * TILE_WIDTH + col] = TRUE;
+            region->queued_rows[region->n_queued] = region->first_row + row;
+            region->queued_cols[region->n_queued] = region->first_col + col;
+            region->n_queued++;
+        }
+
+    }
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////
+// compute_queued:                                                 //
+//   compute every queued pixel and store it in the region's mu   //
+/////////////////////////////////////////////////////////////////////
+void compute_queued(tile_region_t *region){
+
+    compute_points(region->frame, region->queued_rows, region->queued_cols, region->n_queued,
+                   region->queued_mu);
+
+    int k;
+    for(k = 0; k < region->n_queued; k++){
+
+        int row = region->queued_rows[k] - region->first_row;
+        int col = region->queued_cols[k] - region->first_col;
+        region->mu[row * region->stride + col] = region->queued_mu[k];
+
+    }
+
+    region->n_queued = 0;
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////
+// init_tile_area:                                                  //
+//   split a rectangle of the frame along the tiles of its grid    //
+//////////////////////////////////////////////////////////////////////
+void init_tile_area(tile_area_t *area, const frame_t *frame, int first_row, int first_col, int rows, int cols){
+
+    area->first_row = first_row;
+    area->first_col = first_col;
+    area->rows = rows;
+    area->cols = cols;
+
+    // grid tile holding the top left cell, tile sizes are powers of two so this is exact
+    coord_t row = frame->grid_row + first_row;
+    coord_t col = frame->grid_col + first_col;
+    area->tile_row = floor_coord(row / TILE_HEIGHT);
+    area->tile_col = floor_coord(col / TILE_WIDTH);
+    area->row_offset = (int)(row - area->tile_row * TILE_HEIGHT);
+    area->col_offset = (int)(col - area->tile_col * TILE_WIDTH);
+
+    area->tiles_across = (cols + area->col_offset + TILE_WIDTH - 1) / TILE_WIDTH;
+    area->tiles_down = (rows + area->row_offset + TILE_HEIGHT - 1) / TILE_HEIGHT;
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// get_area_tile:                                                          //
+//   find the frame cell at the top left corner of a tile of the area and //
+//   the part of the tile inside the area                                  //
+/////////////////////////////////////////////////////////////////////////////
+void get_area_tile(const tile_area_t *area, int tile, int *corner_row, int *corner_col, rect_t *clip){
+
+    *corner_row = area->first_row - area->row_offset + (tile / area->tiles_across) * TILE_HEIGHT;
+    *corner_col = area->first_col - area->col_offset + (tile % area->tiles_across) * TILE_WIDTH;
+
+    clip->top = *corner_row < area->first_row ? area->first_row : *corner_row;
+    clip->left = *corner_col < area->first_col ? area->first_col : *corner_col;
+    clip->bottom = *corner_row + TILE_HEIGHT;
+    clip->right = *corner_col + TILE_WIDTH;
+
+    if(clip->bottom > area->first_row + area->rows){
+        clip->bottom = area->first_row + area->rows;
+    }
+
+    if(clip->right > area->first_col + area->cols){
+        clip->right = area->first_col + area->cols;
+    }
+
+    // bounds are inclusive
+    clip->bottom--;
+    clip->right--;
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// compute_area_tile:                                                         //
+//   fill mu (rows apart by stride) with the part of a tile of the area      //
+//   inside the area. the tile cache is checked first, and only the pixels   //
+//   it doesn't have yet are computed and added to it. when given, known     //
+//   (rows apart by stride) marks cells mu already holds, they are reused    //
+////////////////////////////////////////////////////////////////////////////////
+void compute_area_tile(const frame_t *frame, const tile_area_t *area, int tile, double *mu, int stride,
+                       const unsigned char *known){
+
+    int corner_row, corner_col;
+    rect_t clip;
+    get_area_tile(area, tile, &corner_row, &corner_col, &clip);
+
+    tile_entry_t *entry = NULL;
+
+    if(frame->cacheable){
+
+        tile_key_t key;
+        make_tile_key(frame, area, tile, &key);
+        entry = tile_cache_acquire(&key);
+
+    }
+
+    // without the cache the tile is computed in a scratch entry
+    tile_entry_t scratch;
+    tile_entry_t *data = entry;
+
+    if(data == NULL){
+        memset(scratch.known, 0, sizeof(scratch.known));
+        data = &scratch;
+    }
+
+    int offset = (clip.top - corner_row) * TILE_WIDTH + (clip.left - corner_col);
+    int rows = clip.bottom - clip.top + 1;
+    int cols = clip.right - clip.left + 1;
+    int row, col;
+
+    // check whether the cache already has every pixel needed
+    int missing = FALSE;
+    for(row = 0; row < rows && !missing; row++){
+        for(col = 0; col < cols && !missing; col++){
+            missing = !data->known[offset + row * TILE_WIDTH + col];
+        }
+    }
+
+    if(entry != NULL){
+        __atomic_fetch_add(missing ? &tile_cache.misses : &tile_cache.hits, 1, __ATOMIC_RELAXED);
+    }
+
+    // take the cells the caller already has
+    if(missing && known != NULL){
+        for(row = 0; row < rows; row++){
+            for(col = 0; col < cols; col++){
+
+                if(known[row * stride + col] && !data->known[offset + row * TILE_WIDTH + col]){
+                    data->mu[offset + row * TILE_WIDTH + col] = mu[row * stride + col];
+                    data->known[offset + row * TILE_WIDTH + col] = TRUE;
+                }
+
+            }
+        }
+    }
+
+    if(missing){
+        compute_tile(frame, clip.top, clip.left, rows, cols, data->mu + offset, TILE_WIDTH, data->known + offset);
+    }
+
+    for(row = 0; row < rows; row++){
+        memcpy(mu + row * stride, data->mu + offset + row * TILE_WIDTH, cols * sizeof(double));
+    }
+
+    if(entry != NULL){
+        tile_cache_release(entry);
+    }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////
+// make_tile_key:                                                //
+//   cache key of a tile of the area                             //
+///////////////////////////////////////////////////////////////////
+void make_tile_key(const frame_t *frame, const tile_area_t *area, int tile, tile_key_t *key){
+
+    // zeroed first, padding is hashed and compared too
+    memset(key, 0, sizeof(tile_key_t));
+
+    key->x_spacing = (frame->display.max_x - frame->display.min_x)/frame->display.screen_width;
+    key->y_spacing = (frame->display.max_y - frame->display.min_y)/frame->display.screen_height;
+    key->tile_row = area->tile_row + tile / area->tiles_across;
+    key->tile_col = area->tile_col + tile % area->tiles_across;
+    key->iterations = frame->iterations;
+    key->precision = frame->precision;
+    key->boundary = frame->boundary;
+    key->formula = frame->formula;
+    key->julia_r = frame->julia_r;
+    key->julia_i = frame->julia_i;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////
+// area_cached:                                                      //
+//   check whether the cache holds every cell of the area, without  //
+//   counting hits or misses                                         //
+///////////////////////////////////////////////////////////////////////
+int area_cached(const frame_t *frame, const tile_area_t *area){
+
+    if(!frame->cacheable){
+        return FALSE;
+    }
+
+    int cached = TRUE;
+    int tile;
+
+    pthread_mutex_lock(&tile_cache.lock);
+
+    for(tile = 0; tile < area->tiles_down * area->tiles_across && cached; tile++){
+
+        int corner_row, corner_col;
+        rect_t clip;
+        get_area_tile(area, tile, &corner_row, &corner_col, &clip);
+
+        tile_key_t key;
+        make_tile_key(frame, area, tile, &key);
+        tile_entry_t *entry = find_tile_entry(&key);
+
+        if(entry == NULL){
+            cached = FALSE;
+            break;
+        }
+
+        int row, col;
+        for(row = clip.top; row <= clip.bottom && cached; row++){
+            for(col = clip.left; col <= clip.right && cached; col++){
+                cached = entry->known[(row - corner_row) * TILE_WIDTH + (col - corner_col)];
+            }
+        }
+
+    }
+
+    pthread_mutex_unlock(&tile_cache.lock);
+    return cached;
+
+}
+
+
+
+////////////////////////////////////////////////////////////////
+// find_tile_entry:                                           //
+//   return the cache entry for key or NULL, the cache lock  //
+//   must be held                                             //
+////////////////////////////////////////////////////////////////
+tile_entry_t *find_tile_entry(const tile_key_t *key){
+
+    if(tile_cache.buckets == NULL){
+        return NULL;
+    }
+
+    tile_entry_t *entry;
+    for(entry = tile_cache.buckets[hash_tile_key(key) % TILE_CACHE_BUCKETS]; entry != NULL; entry = entry->next_in_bucket){
+
+        if(memcmp(&entry->key, key, sizeof(tile_key_t)) == 0){
+            return entry;
+        }
+
+    }
+
+    return NULL;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// tile_cache_acquire:                                                       //
+//   return the cache entry for key, adding an empty one and evicting the   //
+//   least recently used entries to stay under budget if there isn't one.   //
+//   the entry can't be evicted until released. returns NULL when the cache //
+//   is disabled or full of entries in use                                   //
+///////////////////////////////////////////////////////////////////////////////
+tile_entry_t *tile_cache_acquire(const tile_key_t *key){
+
+    pthread_mutex_lock(&tile_cache.lock);
+
+    // the first lookup sets the cache up
+    if(tile_cache.buckets == NULL){
+
+        tile_cache.budget = (size_t)tile_cache_megabytes * 1024 * 1024;
+
+        if(tile_cache.budget < sizeof(tile_entry_t)){
+            pthread_mutex_unlock(&tile_cache.lock);
+            return NULL;
+        }
+
+        tile_cache.buckets = calloc(TILE_CACHE_BUCKETS, sizeof(tile_entry_t *));
+
+        if(tile_cache.buckets == NULL){
+            printf("error allocating memory for tile cache\n");
+            exit(1);
+        }
+
+    }
+
+    unsigned long bucket = hash_tile_key(key) % TILE_CACHE_BUCKETS;
+    tile_entry_t *entry = find_tile_entry(key);
+
+    if(entry != NULL){
+
+        // move to the front of the LRU list
+        unlink_tile_entry(entry);
+        entry->older = tile_cache.newest;
+        entry->newer = NULL;
+
+        if(tile_cache.newest != NULL){
+            tile_cache.newest->newer = entry;
+        }
+
+        tile_cache.newest = entry;
+
+        if(tile_cache.oldest == NULL){
+            tile_cache.oldest = entry;
+        }
+
+        entry->users++;
+        pthread_mutex_unlock(&tile_cache.lock);
+        return entry;
+
+    }
+
+    // make room by evicting the oldest entries nobody is using
+    tile_entry_t *victim = tile_cache.oldest;
+    while(tile_cache.used + sizeof(tile_entry_t) > tile_cache.budget && victim != NULL){
+
+        tile_entry_t *newer = victim->newer;
+
+        if(victim->users == 0){
+
+            // take victim out of its bucket
+            tile_entry_t **link = &tile_cache.buckets[hash_tile_key(&victim->key) % TILE_CACHE_BUCKETS];
+            while(*link != victim){
+                link = &(*link)->next_in_bucket;
+            }
+            *link = victim->next_in_bucket;
+
+            unlink_tile_entry(victim);
+            free(victim);
+
+            tile_cache.used -= sizeof(tile_entry_t);
+            tile_cache.evictions++;
+
+        }
+
+        victim = newer;
+
+    }
+
+    if(tile_cache.used + sizeof(tile_entry_t) > tile_cache.budget){
+        pthread_mutex_unlock(&tile_cache.lock);
+        return NULL;
+    }
+
+    entry = malloc(sizeof(tile_entry_t));
+
+    if(entry == NULL){
+        printf("error allocating memory for tile cache entry\n");
+        exit(1);
+    }
+
+    entry->key = *key;
+    memset(entry->known, 0, sizeof(entry->known));
+    entry->users = 1;
+
+    entry->next_in_bucket = tile_cache.buckets[bucket];
+    tile_cache.buckets[bucket] = entry;
+
+    entry->older = tile_cache.newest;
+    entry->newer = NULL;
+
+    if(tile_cache.newest != NULL){
+        tile_cache.newest->newer = entry;
+    }
+
+    tile_cache.newest = entry;
+
+    if(tile_cache.oldest == NULL){
+        tile_cache.oldest = entry;
+    }
+
+    tile_cache.used += sizeof(tile_entry_t);
+
+    pthread_mutex_unlock(&tile_cache.lock);
+    return entry;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////
+// tile_cache_release:                                       //
+//   let an acquired entry be evicted again                  //
+///////////////////////////////////////////////////////////////
+void tile_cache_release(tile_entry_t *entry){
+
+    pthread_mutex_lock(&tile_cache.lock);
+    entry->users--;
+    pthread_mutex_unlock(&tile_cache.lock);
+
+}
+
+
+
+//////////////////////////////////////////////////////
+// tile_cache_destroy:                              //
+//   free every entry of the tile cache             //
+//////////////////////////////////////////////////////
+void tile_cache_destroy(){
+
+    while(tile_cache.oldest != NULL){
+
+        tile_entry_t *entry = tile_cache.oldest;
+        unlink_tile_entry(entry);
+        free(entry);
+
+    }
+
+    free(tile_cache.buckets);
+    tile_cache.buckets = NULL;
+    tile_cache.used = 0;
+
+}
+
+
+
+/////////////////////////////////////////////////
+// hash_tile_key:                              //
+//   FNV-1a hash of the bytes of a tile key   //
+/////////////////////////////////////////////////
+unsigned long hash_tile_key(const tile_key_t *key){
+
+    const unsigned char *bytes = (const unsigned char *)key;
+    unsigned long hash = 14695981039346656037UL;
+
+    size_t i;
+    for(i = 0; i < sizeof(tile_key_t); i++){
+        hash ^= bytes[i];
+        hash *= 1099511628211UL;
+    }
+
+    return hash;
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// unlink_tile_entry:                                   //
+//   take an entry out of the LRU list of the cache     //
+//////////////////////////////////////////////////////////
+void unlink_tile_entry(tile_entry_t *entry){
+
+    if(entry->newer != NULL){
+        entry->newer->older = entry->older;
+    }else{
+        tile_cache.newest = entry->older;
+    }
+
+    if(entry->older != NULL){
+        entry->older->newer = entry->newer;
+    }else{
+        tile_cache.oldest = entry->newer;
+    }
+
+    entry->newer = NULL;
+    entry->older = NULL;
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// get_render_pool:                                                        //
+//   return the shared render pool, creating it with render_threads workers //
+//   the first time it is needed                                           //
+/////////////////////////////////////////////////////////////////////////////
+render_pool_t *get_render_pool(){
+
+    if(render_pool == NULL){
+        render_pool = render_pool_create(render_threads);
+    }
+
+    return render_pool;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////
+// render_pool_create:                                               //
+//   start n_threads workers, each owning a deque of tiles to render //
+///////////////////////////////////////////////////////////////////////
+render_pool_t *render_pool_create(int n_threads){
+
+    if(n_threads < 1){
+        n_threads = 1;
+    }
+
+    render_pool_t *pool = calloc(1, sizeof(render_pool_t));
+
+    if(pool == NULL){
+        printf("error allocating memory for render pool\n");
+        exit(1);
+    }
+
+    pool->n_threads = n_threads;
+
+    // a single worker renders on the calling thread, no threads needed
+    if(n_threads == 1){
+        return pool;
+    }
+
+    pool->threads = malloc(n_threads * sizeof(pthread_t));
+    pool->workers = malloc(n_threads * sizeof(render_worker_t));
+    pool->deques = calloc(n_threads, sizeof(tile_deque_t));
+
+    if(pool->threads == NULL || pool->workers == NULL || pool->deques == NULL){
+        printf("error allocating memory for render pool\n");
+        exit(1);
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    int i;
+    for(i = 0; i < n_threads; i++){
+
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+
+        pool->workers[i].pool = pool;
+        pool->workers[i].id = i;
+
+        if(pthread_create(&pool->threads[i], NULL, render_worker, &pool->workers[i]) != 0){
+            printf("error starting render thread\n");
+            exit(1);
+        }
+
+    }
+
+    return pool;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+// render_pool_run:                                                      //
+//   call job for every tile in [0, n_tiles) and return once all are    //
+//   done. tiles are handed out in contiguous runs, one per worker deque //
+///////////////////////////////////////////////////////////////////////////
+void render_pool_run(render_pool_t *pool, tile_job_t job, void *context, int n_tiles){
+
+    int i;
+
+    if(pool->n_threads == 1){
+        for(i = 0; i < n_tiles; i++){
+            job(context, i);
+        }
+        return;
+    }
+
+    // grow shared tile storage backing the deques if needed
+    if(n_tiles > pool->tile_capacity){
+
+        free(pool->tile_storage);
+        pool->tile_storage = malloc(n_tiles * sizeof(int));
+        pool->tile_capacity = n_tiles;
+
+        if(pool->tile_storage == NULL){
+            printf("error allocating memory for tile deques\n");
+            exit(1);
+        }
+
+    }
+
+    for(i = 0; i < n_tiles; i++){
+        pool->tile_storage[i] = i;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    // give each worker a contiguous run of tiles
+    for(i = 0; i < pool->n_threads; i++){
+
+        tile_deque_t *deque = &pool->deques[i];
+        int first = (int)((long)n_tiles * i / pool->n_threads);
+        int last = (int)((long)n_tiles * (i + 1) / pool->n_threads);
+
+        pthread_mutex_lock(&deque->lock);
+        deque->tiles = pool->tile_storage + first;
+        deque->top = 0;
+        deque->bottom = last - first;
+        pthread_mutex_unlock(&deque->lock);
+
+    }
+
+    // wake workers and wait until every one has run out of tiles
+    pool->job = job;
+    pool->context = context;
+    pool->busy = pool->n_threads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_ready);
+
+    while(pool->busy > 0){
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+}
+
+
+
+////////////////////////////////////////////////
+// render_pool_destroy:                       //
+//   stop all workers and free the pool       //
+////////////////////////////////////////////////
+void render_pool_destroy(render_pool_t *pool){
+
+    int i;
+
+    if(pool->n_threads > 1){
+
+        pthread_mutex_lock(&pool->lock);
+        pool->shutdown = TRUE;
+        pthread_cond_broadcast(&pool->work_ready);
+        pthread_mutex_unlock(&pool->lock);
+
+        for(i = 0; i < pool->n_threads; i++){
+            pthread_join(pool->threads[i], NULL);
+            pthread_mutex_destroy(&pool->deques[i].lock);
+        }
+
+        pthread_mutex_destroy(&pool->lock);
+        pthread_cond_destroy(&pool->work_ready);
+        pthread_cond_destroy(&pool->work_done);
+
+    }
+
+    free(pool->threads);
+    free(pool->workers);
+    free(pool->deques);
+    free(pool->tile_storage);
+    free(pool);
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// take_tile:                                                              //
+//   pop the next tile from the worker's own deque, or steal the oldest    //
+//   tile from another worker once its own is empty. returns -1 when every //
+//   deque is empty                                                        //
+/////////////////////////////////////////////////////////////////////////////
+int take_tile(render_pool_t *pool, int id){
+
+    int tile = -1;
+
+    // owner pops from the bottom of its own deque
+    tile_deque_t *own = &pool->deques[id];
+    pthread_mutex_lock(&own->lock);
+    if(own->top < own->bottom){
+        tile = own->tiles[--own->bottom];
+    }
+    pthread_mutex_unlock(&own->lock);
+
+    // thieves take from the top, farthest from where the owner is working
+    int i;
+    for(i = 1; tile < 0 && i < pool->n_threads; i++){
+
+        tile_deque_t *victim = &pool->deques[(id + i) % pool->n_threads];
+
+        pthread_mutex_lock(&victim->lock);
+        if(victim->top < victim->bottom){
+            tile = victim->tiles[victim->top++];
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+    }
+
+    return tile;
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////
+// render_worker:                                                  //
+//   thread body, waits for a batch of tiles and works through them //
+/////////////////////////////////////////////////////////////////////
+void *render_worker(void *arg){
+
+    render_worker_t *worker = arg;
+    render_pool_t *pool = worker->pool;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while(TRUE){
+
+        // sleep until a new batch is posted or the pool shuts down
+        while(!pool->shutdown && pool->generation == seen){
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+
+        if(pool->shutdown){
+            break;
+        }
+
+        seen = pool->generation;
+        tile_job_t job = pool->job;
+        void *context = pool->context;
+
+        pthread_mutex_unlock(&pool->lock);
+
+        int tile;
+        while((tile = take_tile(pool, worker->id)) >= 0){
+            job(context, tile);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+
+        // last worker out wakes up render_pool_run
+        pool->busy--;
+        if(pool->busy == 0){
+            pthread_cond_signal(&pool->work_done);
+        }
+
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// draw_bitmap:                                                                                         //
+//   using current fractal display values, construct a bitmap of the specified width and height using a //
+//   defined color palette and save it to the given file name                                           //
+//   the image is rendered in bands of rows, each split into tiles spread over the render pool          //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+void draw_bitmap(char *file_name, window_t display, int image_width, int image_height, COLOR_PALETTE colors){
+
+    // define new window to use with scale() function
+    window_t bitmap_window;
+
+    // use axis values from display. the window isn't snapped, only windows already on their
+    // grid use the tile cache and the others are computed in full
+    bitmap_window.min_x = display.min_x;
+    bitmap_window.max_x = display.max_x;
+    bitmap_window.min_y = display.min_y;
+    bitmap_window.max_y = display.max_y;
+
+    // use image height and width for window height/width
+    bitmap_window.screen_height = image_height;
+    bitmap_window.screen_width = image_width;
+
+    memset(&export_timings, 0, sizeof(export_timings));
+    double stage_start;
+
+
+    // calculate number of bytes per row and necessary number of padding bytes for bitmap
+    int bytes_per_row = (((24 * bitmap_window.screen_width) + 31) / 32) * 4;
+    size_t file_size = BITMAP_HEADER_SIZE + (size_t)bytes_per_row * bitmap_window.screen_height;
+
+    unsigned char header[BITMAP_HEADER_SIZE];
+    fill_bitmap_header(header, bitmap_window.screen_width, bitmap_window.screen_height, bytes_per_row);
+
+    FILE *image = NULL;
+    unsigned char *mapping = NULL;
+
+    if(mapped_export){
+
+        // size the file up front, it reads back as zeros so row padding is already in place
+        int fd = open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if(fd < 0 || ftruncate(fd, file_size) != 0){
+            printf("error opening file for writing\n");
+            exit(1);
+        }
+
+        mapping = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if(mapping == MAP_FAILED){
+            printf("error mapping file for writing\n");
+            exit(1);
+        }
+
+        // the mapping stays valid once the descriptor is closed
+        close(fd);
+        memcpy(mapping, header, BITMAP_HEADER_SIZE);
+
+    }else{
+
+        // open file for writing
+        image = fopen(file_name, "wb");
+
+        // detect a failure to open file
+        if(image == NULL){
+            printf("error opening file for writing\n");
+            exit(1);
+        }
+
+        fwrite(header, 1, BITMAP_HEADER_SIZE, image);
+
+    }
+
+    // bands hold as many rows as fit in BAND_PIXELS
+    int band_height = BAND_PIXELS / bitmap_window.screen_width;
+
+    if(band_height < 1){
+        band_height = 1;
+    }
+
+    if(band_height > bitmap_window.screen_height){
+        band_height = bitmap_window.screen_height;
+    }
+
+    // describe the band of rows being rendered for the workers
+    bitmap_band_t band;
+    band.width = bitmap_window.screen_width;
+    color_table_t *table = create_color_table(colors);
+    band.table = table;
+    band.bytes_per_row = bytes_per_row;
+    band.mu = NULL;
+    band.pixels = NULL;
+    band.rows_above = 0;
+    band.rows_below = 0;
+    band.cols_beside = 0;
+
+    // edge pixels are sampled from the same window at a finer spacing. prepared first since
+    // preparing a frame resets the counters of the export
+    int antialias = antialias_samples > 1;
+
+    if(antialias){
+
+        window_t fine_window = bitmap_window;
+        fine_window.screen_width *= antialias_samples;
+        fine_window.screen_height *= antialias_samples;
+        prepare_frame(&band.fine, fine_window);
+
+    }
+
+    // small exports are computed in one pass and kept, the same window exported again is only
+    // recolored. large ones are computed a band at a time and nothing is kept
+    int streamed = (size_t)bitmap_window.screen_width * bitmap_window.screen_height > EXPORT_CELLS_PIXELS;
+
+    if(streamed){
+
+        release_frame(&export_cells.frame);
+        free(export_cells.mu);
+        free(export_cells.known);
+        memset(&export_cells, 0, sizeof(export_cells));
+
+        prepare_frame(&band.frame, bitmap_window);
+
+        // mapped tiles are colored as soon as they are computed and need no band buffer,
+        // unless edges are looked for in it. it has room for a row above and below the band
+        if(!mapped_export || antialias){
+
+            band.mu = malloc((size_t)(band_height + 2) * band.width * sizeof(double));
+
+            if(band.mu == NULL){
+                printf("error allocating memory for bitmap band\n");
+                exit(1);
+            }
+
+        }
+
+    }else{
+
+        stage_start = monotonic_seconds();
+        compute_cells(&export_cells, bitmap_window);
+        export_timings.compute += monotonic_seconds() - stage_start;
+
+    }
+
+    // zeroed so row padding is already in place
+    if(!mapped_export){
+
+        band.pixels = calloc((size_t)band_height * bytes_per_row, 1);
+
+        if(band.pixels == NULL){
+            printf("error allocating memory for bitmap band\n");
+            exit(1);
+        }
+
+    }
+
+    render_pool_t *pool = get_render_pool();
+    long page_size = sysconf(_SC_PAGESIZE);
+
+    // bitmap rows are stored bottom up, so render bands starting from the bottom of the image
+    int band_end;
+    for(band_end = bitmap_window.screen_height; band_end > 0; band_end -= band_height){
+
+        band.first_row = band_end - band_height < 0 ? 0 : band_end - band_height;
+        band.rows = band_end - band.first_row;
+
+        // mapped bands are colored straight into their place in the file
+        size_t band_offset = BITMAP_HEADER_SIZE + (size_t)(bitmap_window.screen_height - band_end) * bytes_per_row;
+
+        if(mapped_export){
+            band.pixels = mapping + band_offset;
+        }
+
+        // one row of neighbouring bands is kept for edges found across band borders
+        if(antialias){
+            band.rows_above = band.first_row > 0 ? 1 : 0;
+            band.rows_below = band_end < bitmap_window.screen_height ? 1 : 0;
+        }
+
+        if(streamed){
+
+            stage_start = monotonic_seconds();
+            init_band_area(&band);
+            render_pool_run(pool, mapped_export && !antialias ? mapped_tile : band_tile, &band,
+                            band.area.tiles_down * band.area.tiles_across);
+            export_timings.compute += monotonic_seconds() - stage_start;
+
+        }else{
+
+            // the whole image is kept, rows around the band are already computed
+            band.mu = export_cells.mu + (size_t)(band.first_row - band.rows_above) * band.width;
+
+        }
+
+        // coloring pass
+        if(!(streamed && mapped_export && !antialias)){
+            stage_start = monotonic_seconds();
+            render_pool_run(pool, color_band_row, &band, band.rows);
+            export_timings.color += monotonic_seconds() - stage_start;
+        }
+
+        // recolor edge pixels from their samples
+        if(antialias){
+            stage_start = monotonic_seconds();
+            render_pool_run(pool, antialias_band_row, &band, band.rows);
+            export_timings.compute += monotonic_seconds() - stage_start;
+        }
+
+        stage_start = monotonic_seconds();
+
+        if(mapped_export){
+
+            // start writing the band back while the next one renders
+            size_t start = band_offset - band_offset % page_size;
+            msync(mapping + start, band_offset + (size_t)band.rows * bytes_per_row - start, MS_ASYNC);
+
+        }else{
+
+            // band is already in file order, written with one call
+            fwrite(band.pixels, bytes_per_row, band.rows, image);
+
+        }
+
+        export_timings.write += monotonic_seconds() - stage_start;
+
+    }
+
+
+    // free band and color palette memory and close file
+    if(streamed){
+        release_frame(&band.frame);
+    }
+
+    stage_start = monotonic_seconds();
+
+    if(mapped_export){
+
+        if(msync(mapping, file_size, MS_SYNC) != 0){
+            printf("error writing file\n");
+            exit(1);
+        }
+
+        munmap(mapping, file_size);
+
+    }else{
+
+        free(band.pixels);
+        fclose(image);
+
+    }
+
+    export_timings.write += monotonic_seconds() - stage_start;
+
+    if(streamed){
+        free(band.mu);
+    }
+
+    if(antialias){
+        release_frame(&band.fine);
+    }
+
+    free_color_table(table);
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// fill_bitmap_header:                                                     //
+//   write the BMP file header and a BITMAPINFOHEADER for a 24 bit image  //
+//   into the first BITMAP_HEADER_SIZE bytes of header                     //
+/////////////////////////////////////////////////////////////////////////////
+void fill_bitmap_header(unsigned char *header, int width, int height, int bytes_per_row){
+
+    // sizes that don't fit in 32 bits are left as 0, readers go by width and height
+    size_t image_size = (size_t)bytes_per_row * height;
+    size_t file_size = BITMAP_HEADER_SIZE + image_size;
+    unsigned int size_field = file_size > 0xffffffffUL ? 0 : file_size;
+    unsigned int image_size_field = file_size > 0xffffffffUL ? 0 : image_size;
+
+    int offset = BITMAP_HEADER_SIZE;
+    int header_size = 40;
+    short color_planes = 1;
+    short bpp = 24;
+    int compression = 0;
+    int resolution = 2835;
+    int palette_colors = 0;
+
+    memset(header, 0, BITMAP_HEADER_SIZE);
+
+    // file header, the two reserved shorts stay 0
+    header[0] = 'B';
+    header[1] = 'M';
+    memcpy(header + 2, &size_field, 4);
+    memcpy(header + 10, &offset, 4);
+
+    // BITMAPINFOHEADER, 72 dpi
+    memcpy(header + 14, &header_size, 4);
+    memcpy(header + 18, &width, 4);
+    memcpy(header + 22, &height, 4);
+    memcpy(header + 26, &color_planes, 2);
+    memcpy(header + 28, &bpp, 2);
+    memcpy(header + 30, &compression, 4);
+    memcpy(header + 34, &image_size_field, 4);
+    memcpy(header + 38, &resolution, 4);
+    memcpy(header + 42, &resolution, 4);
+    memcpy(header + 46, &palette_colors, 4);
+    memcpy(header + 50, &palette_colors, 4);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// write_frame:                                                              //
+//   write frame index as a bitmap named by pattern, or append its raw BGR  //
+//   pixels to stdout when pattern is -                                      //
+///////////////////////////////////////////////////////////////////////////////
+void write_frame(char *pattern, int index, const unsigned char *pixels, int width, int height){
+
+    if(strcmp(pattern, "-") == 0){
+
+        if(fwrite(pixels, 3, (size_t)width * height, stdout) != (size_t)width * height){
+            fprintf(stderr, "error writing frame to stdout\n");
+            exit(1);
+        }
+
+        return;
+
+    }
+
+    char file_name[4096];
+    snprintf(file_name, sizeof(file_name), pattern, index);
+
+    FILE *image = fopen(file_name, "wb");
+
+    if(image == NULL){
+        fprintf(stderr, "error opening file for writing\n");
+        exit(1);
+    }
+
+    // bitmap rows are stored bottom up and padded to 4 bytes
+    int bytes_per_row = (((24 * width) + 31) / 32) * 4;
+    unsigned char header[BITMAP_HEADER_SIZE];
+    unsigned char padding[3] = {0};
+
+    fill_bitmap_header(header, width, height, bytes_per_row);
+    fwrite(header, 1, BITMAP_HEADER_SIZE, image);
+
+    int row;
+    for(row = height - 1; row >= 0; row--){
+        fwrite(pixels + (size_t)row * width * 3, 3, width, image);
+        fwrite(padding, 1, bytes_per_row - width * 3, image);
+    }
+
+    fclose(image);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////
+// init_band_area:                                                   //
+//   cover the band's rows with tiles, along with the rows and      //
+//   columns kept around it                                          //
+///////////////////////////////////////////////////////////////////////
+void init_band_area(bitmap_band_t *band){
+
+    init_tile_area(&band->area, &band->frame, band->first_row - band->rows_above, -band->cols_beside,
+                   band->rows_above + band->rows + band->rows_below, band->width + 2 * band->cols_beside);
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////
+// band_mu_row:                                                        //
+//   escape values of a row of the band, from -rows_above to           //
+//   rows + rows_below - 1, starting at its first column. the columns  //
+//   kept beside the band are at -1 and width                          //
+/////////////////////////////////////////////////////////////////////////
+double *band_mu_row(const bitmap_band_t *band, int row){
+
+    return band->mu + (size_t)(band->rows_above + row) * (band->width + 2 * band->cols_beside) + band->cols_beside;
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////
+// band_tile:                                                   //
+//   compute one tile of a streamed band, called by workers    //
+//////////////////////////////////////////////////////////////////
+void band_tile(void *context, int tile){
+
+    bitmap_band_t *band = context;
+
+    int corner_row, corner_col;
+    rect_t clip;
+    get_area_tile(&band->area, tile, &corner_row, &corner_col, &clip);
+
+    compute_area_tile(&band->frame, &band->area, tile, band_mu_row(band, clip.top - band->first_row) + clip.left,
+                      band->width + 2 * band->cols_beside, NULL);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////
+// render_band:                                                      //
+//   compute, color and antialias the rows of a band of an export   //
+//   rendered outside draw_bitmap, on the workers of pool. the      //
+//   caller prepares the band's frames and buffers, and sets the    //
+//   rows and columns computed around it for edges on its borders   //
+///////////////////////////////////////////////////////////////////////
+void render_band(render_pool_t *pool, bitmap_band_t *band){
+
+    init_band_area(band);
+    render_pool_run(pool, band_tile, band, band->area.tiles_down * band->area.tiles_across);
+    render_pool_run(pool, color_band_row, band, band->rows);
+
+    if(antialias_samples > 1){
+        render_pool_run(pool, antialias_band_row, band, band->rows);
+    }
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////
+// mapped_tile:                                                   //
+//   compute one tile of a streamed band and color it straight   //
+//   into the mapped file, called by workers                      //
+////////////////////////////////////////////////////////////////////
+void mapped_tile(void *context, int tile){
+
+    bitmap_band_t *band = context;
+
+    double mu[TILE_HEIGHT * TILE_WIDTH];
+
+    int corner_row, corner_col;
+    rect_t clip;
+    get_area_tile(&band->area, tile, &corner_row, &corner_col, &clip);
+
+    compute_area_tile(&band->frame, &band->area, tile, mu, TILE_WIDTH, NULL);
+
+    int row;
+    for(row = clip.top; row <= clip.bottom; row++){
+
+        double *mu_row = mu + (row - clip.top) * TILE_WIDTH;
+
+        // band rows are in file order, bottom row first
+        unsigned char *pixel = band->pixels
+            + (size_t)(band->first_row + band->rows - 1 - row) * band->bytes_per_row
+            + (size_t)clip.left * 3;
+
+        color_row(band->table, mu_row, clip.right - clip.left + 1, pixel);
+
+    }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////
+// color_band_row:                                               //
+//   color one row of the band from its escape values, called   //
+//   by workers                                                  //
+///////////////////////////////////////////////////////////////////
+void color_band_row(void *context, int row){
+
+    bitmap_band_t *band = context;
+
+    const double *mu = band_mu_row(band, row);
+
+    // band rows are kept in file order, bottom row first
+    unsigned char *pixel = band->pixels + (size_t)(band->rows - 1 - row) * band->bytes_per_row;
+
+    color_row(band->table, mu, band->width, pixel);
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////
+// antialias_band_row:                                                    //
+//   find the pixels of one band row that differ from a neighbour, and    //
+//   replace their color with the average of their samples from the fine //
+//   frame, called by workers                                             //
+////////////////////////////////////////////////////////////////////////////
+void antialias_band_row(void *context, int row){
+
+    bitmap_band_t *band = context;
+
+    int n = antialias_samples;
+    int samples = n * n;
+    int width = band->width;
+
+    // neighbours on every side, when there are escape values for them
+    const double *mu = band_mu_row(band, row);
+    const double *above = row > 0 || band->rows_above > 0 ? band_mu_row(band, row - 1) : NULL;
+    const double *below = row < band->rows - 1 || band->rows_below > 0 ? band_mu_row(band, row + 1) : NULL;
+    int beside = band->cols_beside > 0;
+
+    // band rows are kept in file order, bottom row first
+    unsigned char *pixel = band->pixels + (size_t)(band->rows - 1 - row) * band->bytes_per_row;
+
+    int rows[ANTIALIAS_BATCH], cols[ANTIALIAS_BATCH], edges[ANTIALIAS_BATCH];
+    int n_samples = 0, n_edges = 0;
+
+    int col, i, j;
+    for(col = 0; col < width; col++){
+
+        if(!(((col > 0 || beside) && is_edge(mu[col], mu[col - 1])) ||
+             ((col < width - 1 || beside) && is_edge(mu[col], mu[col + 1])) ||
+             (above != NULL && is_edge(mu[col], above[col])) ||
+             (below != NULL && is_edge(mu[col], below[col])))){
+            continue;
+        }
+
+        // sample (i, j) of the pixel is fine cell (row * n + i, col * n + j), the cells a
+        // render at n times the size would average into it
+        for(i = 0; i < n; i++){
+            for(j = 0; j < n; j++){
+                rows[n_samples] = (band->first_row + row) * n + i;
+                cols[n_samples] = col * n + j;
+                n_samples++;
+            }
+        }
+
+        edges[n_edges++] = col;
+
+        if(n_samples + samples > ANTIALIAS_BATCH){
+            antialias_batch(band, rows, cols, n_samples, edges, n_edges, pixel);
+            n_samples = n_edges = 0;
+        }
+
+    }
+
+    if(n_edges > 0){
+        antialias_batch(band, rows, cols, n_samples, edges, n_edges, pixel);
+    }
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////
+// antialias_batch:                                                    //
+//   compute and color the samples of a batch of edge pixels in one    //
+//   row and write each pixel's average color                          //
+/////////////////////////////////////////////////////////////////////////
+void antialias_batch(bitmap_band_t *band, const int *rows, const int *cols, int n_samples,
+                     const int *edges, int n_edges, unsigned char *pixel){
+
+    int samples = n_samples / n_edges;
+
+    double mu[ANTIALIAS_BATCH];
+    unsigned char colors[ANTIALIAS_BATCH * 3];
+
+    compute_points(&band->fine, rows, cols, n_samples, mu);
+    color_row(band->table, mu, n_samples, colors);
+
+    int edge, sample, channel;
+    for(edge = 0; edge < n_edges; edge++){
+        for(channel = 0; channel < 3; channel++){
+
+            int sum = 0;
+
+            for(sample = 0; sample < samples; sample++){
+                sum += colors[(edge * samples + sample) * 3 + channel];
+            }
+
+            pixel[edges[edge] * 3 + channel] = (sum + samples / 2) / samples;
+
+        }
+    }
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////
+// is_edge:                                                     //
+//   TRUE when a pixel and its neighbour are on different sides //
+//   of the set's border, or their escape values are too far    //
+//   apart for one sample to stand for the pixel                //
+//////////////////////////////////////////////////////////////////
+int is_edge(double mu, double neighbour){
+
+    return (mu == 0) != (neighbour == 0) || fabs(mu - neighbour) > antialias_threshold;
+
+}
+
+
+
+// lanes of escape values and table indexes handled together by color_row
+typedef double color_vd __attribute__((vector_size(COLOR_LANES * sizeof(double))));
+typedef int color_vi __attribute__((vector_size(COLOR_LANES * sizeof(int))));
+
+///////////////////////////////////////////////////////////////////////////////
+// color_row:                                                                //
+//   write the BGR colors of n escape values into pixels, 3 bytes each.     //
+//   table indexes are found COLOR_LANES at a time, then looked up          //
+///////////////////////////////////////////////////////////////////////////////
+void color_row(const color_table_t *table, const double *mu, int n, unsigned char *pixels){
+
+    double colors = table->colors;
+    double inverse = 1.0 / table->colors;
+    int size = table->size;
+
+    int start = 0;
+    for(; start + COLOR_LANES <= n; start += COLOR_LANES){
+
+        color_vd m;
+        memcpy(&m, mu + start, sizeof(m));
+
+        // same arithmetic as color_index, lane by lane
+        color_vi wraps = __builtin_convertvector(m * inverse, color_vi);
+        color_vd position = (m - __builtin_convertvector(wraps, color_vd) * colors) * COLOR_TABLE_STEPS + 0.5;
+        color_vi index = __builtin_convertvector(position, color_vi);
+
+        // rounding up past the last entry wraps around to the first, the set takes the
+        // black entry after the palette
+        index &= ~(index >= size);
+        index &= ~(index < 0);
+        color_vi inside = __builtin_convertvector(m == 0, color_vi);
+        index = (index & ~inside) | (size & inside);
+
+        int k;
+        for(k = 0; k < COLOR_LANES; k++){
+            memcpy(pixels + (start + k) * 3, table->entries + index[k] * 4, 3);
+        }
+
+    }
+
+    for(; start < n; start++){
+        memcpy(pixels + start * 3, table->entries + color_index(table, mu[start]) * 4, 3);
+    }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////
+// color_index:                                                  //
+//   entry of the color table holding the color for escape      //
+//   value mu. the palette repeats every table->colors of mu    //
+///////////////////////////////////////////////////////////////////
+int color_index(const color_table_t *table, double mu){
+
+    // if zero c is in set, draw black
+    if(mu == 0){
+        return table->size;
+    }
+
+    int wraps = (int)(mu * (1.0 / table->colors));
+    int index = (int)((mu - (double)wraps * table->colors) * COLOR_TABLE_STEPS + 0.5);
+
+    return index >= table->size || index < 0 ? 0 : index;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// create_color_table:                                                       //
+//   interpolate COLOR_TABLE_STEPS colors from each color of the palette to //
+//   the next one, the last wrapping around to the first                     //
+///////////////////////////////////////////////////////////////////////////////
+color_table_t *create_color_table(COLOR_PALETTE colors){
+
+    unsigned char **palette = create_palette(colors);
+
+    color_table_t *table = malloc(sizeof(color_table_t));
+
+    if(table != NULL){
+        table->colors = palette_size(colors);
+        table->size = table->colors * COLOR_TABLE_STEPS;
+        table->entries = calloc((table->size + 1) * 4, 1);
+    }
+
+    if(table == NULL || table->entries == NULL){
+        printf("error allocating memory for color table\n");
+        exit(1);
+    }
+
+    int i, step, channel;
+    for(i = 0; i < table->colors; i++){
+
+        unsigned char *color1 = palette[i];
+        unsigned char *color2 = palette[(i + 1) % table->colors];
+
+        for(step = 0; step < COLOR_TABLE_STEPS; step++){
+
+            unsigned char *entry = table->entries + (i * COLOR_TABLE_STEPS + step) * 4;
+
+            for(channel = 0; channel < 3; channel++){
+                entry[channel] = round(color1[channel] + (color2[channel] - color1[channel]) * (double)step / COLOR_TABLE_STEPS);
+            }
+
+        }
+
+    }
+
+    free_palette(palette, colors);
+
+    return table;
+
+}
+
+
+
+/////////////////////////////////////////////////
+// free_color_table:                           //
+//   free memory in given color table          //
+/////////////////////////////////////////////////
+void free_color_table(color_table_t *table){
+
+    free(table->entries);
+    free(table);
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// get_gradient_palette:
+//   given two RGB color values as char arrays linearly interpolate *samples* amount of colors between //
+//   them resulting in a gradient                                                                      //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+unsigned char **get_gradient_palette(unsigned char color1[3], unsigned char color2[3], int samples){
+
+    // define palette
+    unsigned char **palette;
+
+    // allocate memory for palette
+    palette = malloc(samples * sizeof(unsigned char*));
+
+    // check for successful allocation, exit on failure
+    if(palette == NULL){
+
+        printf("error allocating memory for gradeent palette\n");
+        exit(1);
+
+    }
+
+    int i;
+    for(i = 0; i < samples; i++){
+
+        // allocate memory for each RGB color
+        palette[i] = malloc(3 * sizeof(unsigned char));
+
+        // check for successful allocation and exit on failure
+        if(palette[i] == NULL){
+
+            printf("error allocating memory for color\n");
+            exit(1);
+
+        }
+
+        // percent difference between first and second color
+        double progress = (1.0/samples) * i;
+
+        // calculate RGB values based on progress
+        double blue = color1[0] + ((color2[0] - color1[0]) * progress);
+        double green = color1[1] + ((color2[1] - color1[1]) * progress);
+        double red = color1[2] + ((color2[2] - color1[2]) * progress);
+        unsigned char b = round(blue);
+        unsigned char g = round(green);
+        unsigned char r = round(red);
+
+        // define color in memory
+        palette[i][0] = b;
+        palette[i][1] = g;
+        palette[i][2] = r;
+    }
+
+    return palette;
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////
+// create_palette:                                                        //
+//   create a color palette corresponding to the given COLOR_PALETTE enum //
+////////////////////////////////////////////////////////////////////////////
+unsigned char **create_palette(COLOR_PALETTE colors){
+
+    // GOLDEN_PURPLE colors
+    unsigned char gp_purple[] = {0x72, 0x02, 0x61};
+    unsigned char gp_gold[] = {0x1b, 0x80, 0x99};
+    unsigned char gp_blue[] = {0x88, 0x5e, 0x06};
+
+    // PASTEL_RAINBOW colors
+    unsigned char pr_blue[] = {0x6a, 0x4e, 0x23};
+    unsigned char pr_green[] = {0x31, 0x80, 0x26};
+    unsigned char pr_yellow[] = {0x30, 0x72, 0xa5};
+    unsigned char pr_red[] = {0x30, 0x36, 0xa5};
+
+    // SCARLET_GRAY colors
+    unsigned char sg_red[] = {0x0, 0x0, 0xbb};
+    unsigned char sg_gray[] = {0x66, 0x66, 0x66};
+    unsigned char sg_white[] = {0xff, 0xff, 0xff};
+
+    // OCEAN colors
+    unsigned char o_lightgreen[] = {0x29, 0xd4, 0x9f};
+    unsigned char o_bluegreen[] = {0x5d, 0x94, 0x14};
+    unsigned char o_turquoise[] = {0x4d, 0x67, 0x0b};
+    unsigned char o_marine[] = {0x43, 0x45, 0x0a};
+
+    // EARTH colors
+    unsigned char e_darkgreen[] = {0x00, 0x4d, 0x33};
+    unsigned char e_lightgreen[] = {0x18, 0x9e, 0x90};
+    unsigned char e_beige[] = {0x74, 0x85, 0xa1};
+    unsigned char e_brown[] = {0x2a, 0x43, 0x77};
+
+    // HIGHLIGHTERS colors
+    unsigned char h_yellow[] = {0x15, 0xf3, 0xf3};
+    unsigned char h_green[] = {0x2c, 0xf5, 0x83};
+    unsigned char h_pink[] = {0x99, 0x00, 0xff};
+    unsigned char h_purple[] = {0xd0, 0x0d, 0x6e};
+
+    // GRAY_SCALE colors
+    unsigned char gs_white[] = {0xff, 0xff, 0xff};
+    unsigned char gs_gray[] = {0x33, 0x33, 0x33};
+
+    // MATRIX colors
+    unsigned char m_green1[] = {0x48, 0xe1, 0x02};
+    unsigned char m_green2[] = {0x13, 0x62, 0x08};
+    unsigned char m_green3[] = {0x0b, 0x4a, 0x04};
+
+    // final palette to be returned
+    unsigned char **palette = NULL;
+
+    // gradient palettes to be combined
+    unsigned char **palette1;
+    unsigned char **palette2;
+    unsigned char **palette3;
+
+    // for array indexing later
+    int i;
+    
+
+    // construct palette
+    switch(colors){
+
+        case GOLDEN_PURPLE:
+
+            // allocate palette memory
+            palette = malloc(8 * sizeof(unsigned char*));
+
+            // check for successful allocation, exit on failure
+            if(palette == NULL){
+                printf("error allocating memory for palette\n");
+                exit(1);
+            }
+            
+            // get intermediate gradients between colors
+            palette1 = get_gradient_palette(gp_gold, gp_purple, 4);
+            palette2 = get_gradient_palette(gp_purple, gp_blue, 4);
+
+            // put gradients into final palette
+            for(i=0; i < 4; i++){
+
+                palette[i] = palette1[i];
+                palette[i+4] = palette2[i];
+
+            }
+
+        break;
+
+        case PASTEL_RAINBOW:
+
+            // allocate palette memory
+            palette = malloc(12 * sizeof(unsigned char*));
+
+            // check for successful allocation, exit on failure
+            if(palette == NULL){
+                printf("error allocating memory for palette\n");
+                exit(1);
+            }
+
+            // get intermediate gradients between colors
+            palette1 = get_gradient_palette(pr_blue, pr_red, 4);
+            palette2 = get_gradient_palette(pr_red, pr_yellow, 4);
+            palette3 = get_gradient_palette(pr_yellow, pr_green, 4);
+
+            // put gradients into final palette
+            for(i = 0; i < 4; i++){
+
+                palette[i] = palette1[i];
+                palette[i+4] = palette2[i];
+                palette[i+8] = palette3[i];
+
+            }
+
+        break;
+
+        case SCARLET_GRAY:
+
+            // allocate palette memory
+            palette = malloc(8 * sizeof(unsigned char*));
+
+            // check for successful allocation, exit on failure
+            if(palette == NULL){
+                printf("error allocating memory for palette\n");
+                exit(1);
+            }
+
+
+            // get intermediate gradients between colors
+            palette1 = get_gradient_palette(sg_gray, sg_red, 4);
+            palette2 = get_gradient_palette(sg_red, sg_white, 4);
+
+            // put gradients into final palette
+            for(i=0; i < 4; i++){
+
+                palette[i] = palette1[i];
+                palette[i+4] = palette2[i];
+
+            }
+
+        break;
+
+        case OCEAN:
+
+            // allocate palette memory
+            palette = malloc(9 * sizeof(unsigned char*));
+
+            // check for successful allocation, exit on failure
+            if(palette == NULL){
+                printf("error allocating memory for palette\n");
+                exit(1);
+            }
+
+
+            // get intermediate gradients between colors
+            palette1 = get_gradient_palette(o_lightgreen, o_bluegreen, 3);
+            palette2 = get_gradient_palette(o_bluegreen, o_turquoise, 3);
+            palette3 = get_gradient_palette(o_turquoise, o_marine, 3);
+
+            // put gradients into final palette
+            for(i = 0; i < 3; i++){
+
+                palette[i] = palette1[i];
+                palette[i+3] = palette2[i];
+                palette[i+6] = palette3[i];
+
+            }
+
+        break;
+
+        case EARTH:
+
+            // allocate palette memory
+            palette = malloc(12 * sizeof(unsigned char*));
+
+            // check for successful allocation, exit on failure
+            if(palette == NULL){
+                printf("error allocating memory for palette\n");
+                exit(1);
+            }
+
+
+            // get intermediate gradients between colors
+            palette1 = get_gradient_palette(e_beige, e_brown, 4);
+            palette2 = get_gradient_palette(e_brown, e_lightgreen, 4);
+            palette3 = get_gradient_palette(e_lightgreen, e_darkgreen, 4);
+
+            // put gradients into final palette
+            for(i = 0; i < 4; i++){
+
+                palette[i] = palette1[i];
+                palette[i+4] = palette2[i];
+                palette[i+8] = palette3[i];
+
+            }
+
+        break;
+
+        case HIGHLIGHTERS:
+
+            // allocate palette memory
+            palette = malloc(12 * sizeof(unsigned char*));
+
+            // check for successful allocation, exit on failure
+            if(palette == NULL){
+                printf("error allocating memory for palette\n");
+                exit(1);
+            }
+
+
+            // get intermediate gradients between colors
+            palette1 = get_gradient_palette(h_green, h_yellow, 4);
+            palette2 = get_gradient_palette(h_yellow, h_pink, 4);
+            palette3 = get_gradient_palette(h_pink, h_purple, 4);
+
+            // put gradients into final palette
+            for(i = 0; i < 4; i++){
+
+                palette[i] = palette1[i];
+                palette[i+4] = palette2[i];
+                palette[i+8] = palette3[i];
+
+            }
+
+        break;
+
+        case GRAY_SCALE:
+
+            // get gradient between gray and white
+            palette = get_gradient_palette(gs_white, gs_gray, 8);
+
+        break;
+
+        case MATRIX:
+
+            // allocate palette memory
+            palette = malloc(8 * sizeof(unsigned char*));
+
+            // check for successful allocation, exit on failure
+            if(palette == NULL){
+                printf("error allocating memory for palette\n");
+                exit(1);
+            }
+
+
+            // get intermediate gradients between colors
+            palette1 = get_gradient_palette(m_green3, m_green2, 4);
+            palette2 = get_gradient_palette(m_green2, m_green1, 4);
+
+            // put gradients into final palette
+            for(i = 0; i < 4; i++){
+
+                palette[i] = palette1[i];
+                palette[i+4] = palette2[i];
+
+            }
+
+        break;
+
+    }
+    
+
+    palette1 = NULL;
+    palette2 = NULL;
+    palette3 = NULL;
+    return palette;
+
+}
+
+
+
+//////////////////////////////////////////////
+// palette_size:                             //
+//   number of colors in the given palette   //
+//////////////////////////////////////////////
+int palette_size(COLOR_PALETTE colors){
+
+    switch(colors){
+
+        // 9 color palettes
+        case OCEAN:
+            return 9;
+
+        // 12 color palettes
+        case PASTEL_RAINBOW:
+        case EARTH:
+        case HIGHLIGHTERS:
+            return 12;
+
+        // 8 color palettes
+        default:
+            return 8;
+
+    }
+
+}
+
+
+
+////////////////////////////////////
+// free_palette:                  //
+//   free memory in given palette //
+////////////////////////////////////
+void free_palette(unsigned char **palette, COLOR_PALETTE colors){
+
+    int i;
+    for(i = 0; i < palette_size(colors); i++){
+        free(palette[i]);
+    }
+
+    free(palette);
+
+}
+
+
+
+//////////////////////////////////////////////////////
+// monotonic_seconds:                               //
+//   seconds on a clock unaffected by time changes, //
+//   for timing stages against each other           //
+//////////////////////////////////////////////////////
+double monotonic_seconds(){
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+
+}
@@ -0,0 +1,679 @@
+#ifndef FRACTAL_H
+#define FRACTAL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <float.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+
+// ncurses defines these too, the render core is also built without it
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define DEFAULT_ITERATIONS 100
+
+// automatic iteration limit: extra iterations for every halving of the view width,
+// the highest limit it goes to, and the share of escaped cells along the set's edge
+// that escaping late raises the limit, or escaping early lowers it
+#define ITERATIONS_PER_OCTAVE 20
+#define AUTO_MAX_ITERATIONS 65536
+#define AUTO_RAISE_FRACTION 0.25
+#define AUTO_LOWER_FRACTION 0.02
+
+// size of the tiles render workers pick up, and the number of pixels in the row bands
+// bitmaps are written in
+#define TILE_WIDTH 64
+#define TILE_HEIGHT 16
+#define BAND_PIXELS (1 << 22)
+
+// largest export whose escape values are kept for recoloring, bigger ones are streamed
+// band by band so memory stays bounded
+#define EXPORT_CELLS_PIXELS (1 << 24)
+
+// bytes of the BMP file header and BITMAPINFOHEADER
+#define BITMAP_HEADER_SIZE 54
+
+// color table entries per palette color, 8 color palettes get 4096, and the escape
+// values colored at once by color_row
+#define COLOR_TABLE_STEPS 512
+#define COLOR_LANES 4
+
+// antialiased exports: escape value difference to a neighbour that marks a pixel as an
+// edge, the most samples per side of an edge pixel, and the samples computed at once
+#define ANTIALIAS_THRESHOLD 0.5
+#define ANTIALIAS_MAX_SAMPLES 16
+#define ANTIALIAS_BATCH (ANTIALIAS_MAX_SAMPLES * ANTIALIAS_MAX_SAMPLES)
+
+// distance to the set's boundary, in pixels, under which escaping points are drawn as
+// part of the set when boundaries are drawn from distance estimates
+#define BOUNDARY_WIDTH 1.0
+
+// escaped orbits are iterated on until |z| reaches DISTANCE_RADIUS, for at most
+// DISTANCE_STEPS iterations, before their distance is estimated
+#define DISTANCE_RADIUS 1e10
+#define DISTANCE_STEPS 8
+
+// number of FORMULA values, every escape kernel is generated once for each of them
+#define FORMULAS 5
+
+// constant of the julia set drawn by default, a dendrite-like set with spirals
+#define DEFAULT_JULIA_R -0.8
+#define DEFAULT_JULIA_I 0.156
+
+// coordinate rounding error allowed per pixel, as a fraction of the pixel spacing
+#define PRECISION_MARGIN 256
+
+// significant bits kept in the cell spacing when the window is snapped to its grid.
+// with PRECISION_MARGIN = 2^GRID_BITS every cell coordinate is exact in its tier
+#define GRID_BITS 8
+
+// number of points converted to a tier's type at once by compute_points
+#define SPAN_CHUNK 64
+
+// perturbation: relative size allowed for the dropped series term, the |z|/|Z| ratio
+// below which a pixel is considered glitched, and how many times glitched pixels
+// are moved to a new reference before falling back to direct quad iteration
+#define SERIES_TOLERANCE 1e-6
+#define GLITCH_TOLERANCE 1e-6
+#define MAX_REBASES 4
+
+// default memory budget of the tile cache and number of hash buckets it uses
+#define TILE_CACHE_MEGABYTES 64
+#define TILE_CACHE_BUCKETS 4096
+
+///////////////////////////
+// Structure definitions //
+///////////////////////////
+
+// window coordinates are kept in quad precision so deep zooms stay addressable
+typedef __float128 coord_t;
+
+typedef struct {
+
+    long double a;
+    long double b;
+
+}complex_t;
+
+typedef struct {
+
+    coord_t min_x;
+    coord_t max_x;
+
+    coord_t min_y;
+    coord_t max_y;
+
+    int screen_height;
+    int screen_width;
+
+}window_t;
+
+typedef enum {
+    GOLDEN_PURPLE = 0,
+    PASTEL_RAINBOW = 1,
+    SCARLET_GRAY = 2,
+    OCEAN = 3,
+    EARTH = 4,
+    HIGHLIGHTERS = 5,
+    GRAY_SCALE = 6,
+    MATRIX = 7
+}COLOR_PALETTE;
+
+// floating point types the escape kernels can iterate in, cheapest first
+typedef enum {
+    PRECISION_FLOAT = 0,
+    PRECISION_DOUBLE = 1,
+    PRECISION_EXTENDED = 2,
+    PRECISION_QUAD = 3,
+    PRECISION_PERTURBATION = 4,
+    PRECISION_AUTO = 5
+}PRECISION;
+
+// iterations the kernels can run. mandelbrot, multibrot and burning ship iterate
+// from z = 0 with c at the pixel, julia sets from z at the pixel with a constant c
+typedef enum {
+    MANDELBROT = 0,
+    JULIA = 1,
+    MULTIBROT3 = 2,
+    MULTIBROT4 = 3,
+    BURNING_SHIP = 4
+}FORMULA;
+
+// high precision orbit of one reference point, other pixels iterate as a delta from it
+typedef struct {
+
+    // Z_n for n = 0..length, stored in double once computed in quad, and the
+    // iteration limit of the frame it was computed for
+    double *zr;
+    double *zi;
+    int length;
+    int iterations;
+
+    // pixel the orbit belongs to and the pixel spacing on the complex plane
+    double ref_row;
+    double ref_col;
+    double dx;
+    double dy;
+
+    // series approximation delta_skip = a*dc + b*dc^2 + c*dc^3, as {real, imag},
+    // valid for deltas up to radius
+    int skip;
+    double radius;
+    double a[2];
+    double b[2];
+    double c[2];
+
+}reference_orbit_t;
+
+// what the pixels of the current frame cost. first the pixels decided without running
+// the full iteration loop, per shortcut
+typedef struct {
+
+    long cardioid;
+    long bulb;
+    long periodic;
+
+    // pixels filled in by rectangle subdivision
+    long filled;
+
+    // pixels that escaped, and those that reached the iteration limit without escaping
+    // or being decided
+    long escaped;
+    long exhausted;
+
+    // iterations run by the kernels over all pixels
+    long iterations;
+
+}frame_counters_t;
+
+// everything a worker needs to compute points of one frame
+typedef struct {
+
+    window_t display;
+    PRECISION precision;
+    int iterations;
+
+    // iteration and the constant c of julia sets, 0 for the other formulas
+    FORMULA formula;
+    coord_t julia_r;
+    coord_t julia_i;
+
+    // rectangles with a border in the set are filled, which needs a connected and full set
+    int fill_interiors;
+
+    // only set when precision is PRECISION_PERTURBATION
+    reference_orbit_t *reference;
+
+    // estimated distance on the complex plane under which escaping points are drawn as the
+    // set, 0 when the frame is iterated without distance estimates
+    double boundary;
+
+    // grid index of cell (0, 0), and whether the window is snapped so its tiles can be cached
+    coord_t grid_row;
+    coord_t grid_col;
+    int cacheable;
+
+}frame_t;
+
+// cells of a frame split along the tiles of its grid, tiles are counted from
+// the one holding the area's top left cell
+typedef struct {
+
+    int first_row;
+    int first_col;
+    int rows;
+    int cols;
+
+    // grid index of the first tile and how far into it the area starts
+    coord_t tile_row;
+    coord_t tile_col;
+    int row_offset;
+    int col_offset;
+
+    int tiles_across;
+    int tiles_down;
+
+}tile_area_t;
+
+// identifies a tile of the snapped grid, compared and hashed as raw bytes
+typedef struct {
+
+    coord_t x_spacing;
+    coord_t y_spacing;
+    coord_t tile_row;
+    coord_t tile_col;
+    coord_t julia_r;
+    coord_t julia_i;
+    int iterations;
+    int precision;
+    int formula;
+    double boundary;
+
+}tile_key_t;
+
+// cached escape values of one grid tile, entries are also on an LRU list
+typedef struct tile_entry tile_entry_t;
+struct tile_entry {
+
+    tile_key_t key;
+    double mu[TILE_HEIGHT * TILE_WIDTH];
+    unsigned char known[TILE_HEIGHT * TILE_WIDTH];
+
+    // workers using the entry, it can't be evicted until they are done
+    int users;
+
+    tile_entry_t *next_in_bucket;
+    tile_entry_t *newer;
+    tile_entry_t *older;
+
+};
+
+// tiles kept between frames under a memory budget, least recently used go first
+typedef struct {
+
+    pthread_mutex_t lock;
+    tile_entry_t **buckets;
+    tile_entry_t *newest;
+    tile_entry_t *oldest;
+
+    size_t budget;
+    size_t used;
+
+    long hits;
+    long misses;
+    long evictions;
+
+}tile_cache_t;
+
+// batch escape-time kernels, compute mu for n points of the complex plane, with the
+// formula, iteration limit and julia constant of frame
+typedef void (*escape_kernel_t)(const double *x, const double *y, double *mu, int n, const frame_t *frame);
+typedef void (*escape_kernel_float_t)(const float *x, const float *y, double *mu, int n, const frame_t *frame);
+typedef void (*escape_kernel_extended_t)(const long double *x, const long double *y, double *mu, int n, const frame_t *frame);
+typedef void (*escape_kernel_quad_t)(const __float128 *x, const __float128 *y, double *mu, int n, const frame_t *frame);
+
+// the same kernels also tracking dz/dc, they add the estimated distance from each point
+// to the set's boundary, 0 for points that don't escape
+typedef void (*distance_kernel_t)(const double *x, const double *y, double *mu, double *distance, int n, const frame_t *frame);
+typedef void (*distance_kernel_float_t)(const float *x, const float *y, double *mu, double *distance, int n, const frame_t *frame);
+typedef void (*distance_kernel_extended_t)(const long double *x, const long double *y, double *mu, double *distance, int n,
+                                           const frame_t *frame);
+typedef void (*distance_kernel_quad_t)(const __float128 *x, const __float128 *y, double *mu, double *distance, int n,
+                                       const frame_t *frame);
+
+// vector kernels for one instruction set, one of each per formula. formulas without a
+// distance estimate have no distance kernels
+typedef struct {
+
+    const char *name;
+    const char *cpu_feature;
+    escape_kernel_t kernel[FORMULAS];
+    escape_kernel_float_t kernel_float[FORMULAS];
+    distance_kernel_t distance_kernel[FORMULAS];
+    distance_kernel_float_t distance_kernel_float[FORMULAS];
+
+}escape_engine_t;
+
+// scalar kernels of one formula for the precision tiers wider than double
+typedef struct {
+
+    escape_kernel_extended_t kernel_extended;
+    escape_kernel_quad_t kernel_quad;
+    distance_kernel_extended_t distance_kernel_extended;
+    distance_kernel_quad_t distance_kernel_quad;
+
+}formula_kernels_t;
+
+// render job run by pool workers for each tile index
+typedef void (*tile_job_t)(void *context, int tile);
+
+// tiles owned by one worker, owner pops from bottom and thieves steal from top
+typedef struct {
+
+    pthread_mutex_t lock;
+    int *tiles;
+    int top;
+    int bottom;
+
+}tile_deque_t;
+
+typedef struct render_pool render_pool_t;
+
+typedef struct {
+
+    render_pool_t *pool;
+    int id;
+
+}render_worker_t;
+
+// persistent set of worker threads with work-stealing tile deques
+struct render_pool {
+
+    int n_threads;
+    pthread_t *threads;
+    render_worker_t *workers;
+    tile_deque_t *deques;
+
+    // backing storage shared by all deques
+    int *tile_storage;
+    int tile_capacity;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+
+    // current batch, generation changes every time a batch is posted
+    unsigned long generation;
+    tile_job_t job;
+    void *context;
+    int busy;
+    int shutdown;
+
+};
+
+// off-screen escape values for every cell of the interactive view
+typedef struct {
+
+    frame_t frame;
+    double *mu;
+    size_t capacity;
+
+    int width;
+    int height;
+
+    // part of the buffer being computed by the render pool
+    tile_area_t area;
+
+    // cells sampled by progressive passes, only used while seeded is set
+    unsigned char *known;
+    int seeded;
+
+}cell_buffer_t;
+
+// one coarse pass of a progressive render, samples every step cells
+typedef struct {
+
+    cell_buffer_t *cells;
+    int step;
+
+}progressive_pass_t;
+
+// palette spread over COLOR_TABLE_STEPS entries per color so a pixel is colored with
+// one lookup. entries are BGR padded to 4 bytes, entry size is black for the set
+typedef struct {
+
+    unsigned char *entries;
+    int colors;
+    int size;
+
+}color_table_t;
+
+// band of bitmap rows rendered by the workers during an export
+typedef struct {
+
+    // escape values of the band's rows, computed per band when the export is streamed.
+    // mu also holds the rows and columns kept around the band, see band_mu_row
+    frame_t frame;
+    tile_area_t area;
+    double *mu;
+    int width;
+
+    const color_table_t *table;
+
+    // frame with antialias_samples times the resolution that edge pixels are supersampled
+    // from, and the rows of escape values kept above and below the band and the columns
+    // kept on either side, so edges are found across its borders
+    frame_t fine;
+    int rows_above;
+    int rows_below;
+    int cols_beside;
+
+    // band pixel rows in file order, bottom row first, including padding
+    unsigned char *pixels;
+    int bytes_per_row;
+
+    int first_row;
+    int rows;
+
+}bitmap_band_t;
+
+// seconds the last bitmap export spent in each stage
+typedef struct {
+
+    double compute;
+    double color;
+    double write;
+
+}export_timings_t;
+
+// rectangle of a tile with inclusive bounds, relative to the tile
+typedef struct {
+
+    int top;
+    int left;
+    int bottom;
+    int right;
+
+}rect_t;
+
+// tile being filled by rectangle subdivision, rows and columns are relative to the tile
+typedef struct {
+
+    const frame_t *frame;
+    int first_row;
+    int first_col;
+
+    double *mu;
+    int stride;
+
+    // pixels whose mu has already been computed or filled
+    unsigned char known[TILE_HEIGHT * TILE_WIDTH];
+
+    // pixels waiting to be computed together, in frame coordinates
+    int n_queued;
+    int queued_rows[TILE_HEIGHT * TILE_WIDTH];
+    int queued_cols[TILE_HEIGHT * TILE_WIDTH];
+    double queued_mu[TILE_HEIGHT * TILE_WIDTH];
+
+}tile_region_t;
+
+//////////////////////////
+// Function definitions //
+//////////////////////////
+
+// escape kernels of every formula, generated by DEFINE_FORMULA and DEFINE_FORMULA_DISTANCE
+#define DECLARE_FORMULA_KERNELS(FORMULA)                                                                          \
+void escape_kernel_scalar_##FORMULA(const double *x, const double *y, double *mu, int n, const frame_t *frame);  \
+void escape_kernel_sse2_##FORMULA(const double *x, const double *y, double *mu, int n, const frame_t *frame);    \
+void escape_kernel_avx2_##FORMULA(const double *x, const double *y, double *mu, int n, const frame_t *frame);    \
+void escape_kernel_avx512_##FORMULA(const double *x, const double *y, double *mu, int n, const frame_t *frame);  \
+void escape_kernel_scalar_float_##FORMULA(const float *x, const float *y, double *mu, int n, const frame_t *frame); \
+void escape_kernel_sse2_float_##FORMULA(const float *x, const float *y, double *mu, int n, const frame_t *frame); \
+void escape_kernel_avx2_float_##FORMULA(const float *x, const float *y, double *mu, int n, const frame_t *frame); \
+void escape_kernel_avx512_float_##FORMULA(const float *x, const float *y, double *mu, int n, const frame_t *frame); \
+void escape_kernel_extended_##FORMULA(const long double *x, const long double *y, double *mu, int n, const frame_t *frame); \
+void escape_kernel_quad_##FORMULA(const __float128 *x, const __float128 *y, double *mu, int n, const frame_t *frame);
+
+#define DECLARE_FORMULA_DISTANCE(FORMULA)                                                                         \
+void distance_kernel_scalar_##FORMULA(const double *x, const double *y, double *mu, double *distance, int n,     \
+                                      const frame_t *frame);                                                      \
+void distance_kernel_sse2_##FORMULA(const double *x, const double *y, double *mu, double *distance, int n,       \
+                                    const frame_t *frame);                                                        \
+void distance_kernel_avx2_##FORMULA(const double *x, const double *y, double *mu, double *distance, int n,       \
+                                    const frame_t *frame);                                                        \
+void distance_kernel_avx512_##FORMULA(const double *x, const double *y, double *mu, double *distance, int n,     \
+                                      const frame_t *frame);                                                      \
+void distance_kernel_scalar_float_##FORMULA(const float *x, const float *y, double *mu, double *distance, int n,  \
+                                            const frame_t *frame);                                                \
+void distance_kernel_sse2_float_##FORMULA(const float *x, const float *y, double *mu, double *distance, int n,    \
+                                          const frame_t *frame);                                                  \
+void distance_kernel_avx2_float_##FORMULA(const float *x, const float *y, double *mu, double *distance, int n,    \
+                                          const frame_t *frame);                                                  \
+void distance_kernel_avx512_float_##FORMULA(const float *x, const float *y, double *mu, double *distance, int n,  \
+                                            const frame_t *frame);                                                \
+void distance_kernel_extended_##FORMULA(const long double *x, const long double *y, double *mu, double *distance, \
+                                        int n, const frame_t *frame);                                             \
+void distance_kernel_quad_##FORMULA(const __float128 *x, const __float128 *y, double *mu, double *distance, int n, \
+                                    const frame_t *frame);
+
+DECLARE_FORMULA_KERNELS(mandelbrot)
+DECLARE_FORMULA_KERNELS(julia)
+DECLARE_FORMULA_KERNELS(multibrot3)
+DECLARE_FORMULA_KERNELS(multibrot4)
+DECLARE_FORMULA_KERNELS(burning_ship)
+DECLARE_FORMULA_DISTANCE(mandelbrot)
+DECLARE_FORMULA_DISTANCE(julia)
+DECLARE_FORMULA_DISTANCE(multibrot3)
+DECLARE_FORMULA_DISTANCE(multibrot4)
+
+// mandelbrot functions
+complex_t complex_multiply(complex_t x, complex_t y);
+complex_t complex_add(complex_t x, complex_t y);
+complex_t complex_sub(complex_t x, complex_t y);
+long double complex_magnitude(complex_t x);
+complex_t scale(window_t display, int row, int column);
+void scale_quad(window_t display, int row, int col, __float128 *a, __float128 *b);
+void snap_window(window_t *display);
+coord_t round_coord(coord_t x);
+coord_t floor_coord(coord_t x);
+double is_in_set(complex_t c, int iterations);
+
+// escape kernel functions
+void init_escape_kernel(const char *requested);
+int cpu_supports(const char *feature);
+void add_frame_counters(const frame_counters_t *counts);
+PRECISION choose_precision(window_t display);
+int choose_iterations(window_t display);
+double choose_boundary(window_t display);
+void mark_boundary(const frame_t *frame, double *mu, const double *distance, int n);
+void adapt_iterations(const cell_buffer_t *cells);
+void compute_span(const frame_t *frame, int row, int first_col, int n, double *mu);
+void compute_points(const frame_t *frame, const int *rows, const int *cols, int n, double *mu);
+void compute_offsets(const frame_t *frame, const double *dx, const double *dy, int n, double *mu);
+void prepare_frame(frame_t *frame, window_t display);
+void prepare_frame_iterations(frame_t *frame, window_t display, int iterations);
+void set_frame_formula(frame_t *frame);
+void set_frame_grid(frame_t *frame);
+void release_frame(frame_t *frame);
+
+// perturbation functions
+reference_orbit_t *compute_reference_orbit(window_t display, int iterations, int ref_row, int ref_col, int use_series);
+void free_reference_orbit(reference_orbit_t *orbit);
+int perturb_point(const reference_orbit_t *orbit, double dcr, double dci, double *mu, double *distance, long *iterated);
+void perturb_points(const frame_t *frame, const int *rows, const int *cols, int n, double *mu);
+void perturb_offsets(const frame_t *frame, const double *dx, const double *dy, int n, double *mu);
+void compute_cells(cell_buffer_t *cells, window_t display);
+void reset_cells(cell_buffer_t *cells, window_t display);
+void sample_row(void *context, int index);
+int shift_cells(cell_buffer_t *cells, window_t display);
+void compute_cell_area(cell_buffer_t *cells, int first_row, int first_col, int rows, int cols);
+void cell_tile(void *context, int tile);
+
+// rectangle subdivision functions
+void compute_tile(const frame_t *frame, int first_row, int first_col, int rows, int cols, double *mu, int stride,
+                  unsigned char *known);
+void subdivide_tile(tile_region_t *region, int rows, int cols);
+int subdivide_rect(tile_region_t *region, rect_t rect, rect_t *halves);
+void queue_border(tile_region_t *region, rect_t rect);
+void queue_region_run(tile_region_t *region, int row, int left, int right);
+void compute_queued(tile_region_t *region);
+
+// tile cache functions
+void init_tile_area(tile_area_t *area, const frame_t *frame, int first_row, int first_col, int rows, int cols);
+void get_area_tile(const tile_area_t *area, int tile, int *corner_row, int *corner_col, rect_t *clip);
+void compute_area_tile(const frame_t *frame, const tile_area_t *area, int tile, double *mu, int stride,
+                       const unsigned char *known);
+void make_tile_key(const frame_t *frame, const tile_area_t *area, int tile, tile_key_t *key);
+int area_cached(const frame_t *frame, const tile_area_t *area);
+tile_entry_t *find_tile_entry(const tile_key_t *key);
+tile_entry_t *tile_cache_acquire(const tile_key_t *key);
+unsigned long hash_tile_key(const tile_key_t *key);
+void unlink_tile_entry(tile_entry_t *entry);
+void tile_cache_release(tile_entry_t *entry);
+void tile_cache_destroy();
+
+// render pool functions
+render_pool_t *get_render_pool();
+render_pool_t *render_pool_create(int n_threads);
+void render_pool_run(render_pool_t *pool, tile_job_t job, void *context, int n_tiles);
+void render_pool_destroy(render_pool_t *pool);
+int take_tile(render_pool_t *pool, int id);
+void *render_worker(void *arg);
+
+// bitmap functions
+void draw_bitmap(char *file_name, window_t display, int image_width, int image_height, COLOR_PALETTE colors);
+void fill_bitmap_header(unsigned char *header, int width, int height, int bytes_per_row);
+void write_frame(char *pattern, int index, const unsigned char *pixels, int width, int height);
+void init_band_area(bitmap_band_t *band);
+double *band_mu_row(const bitmap_band_t *band, int row);
+void band_tile(void *context, int tile);
+void render_band(render_pool_t *pool, bitmap_band_t *band);
+void mapped_tile(void *context, int tile);
+void color_band_row(void *context, int row);
+void antialias_band_row(void *context, int row);
+void antialias_batch(bitmap_band_t *band, const int *rows, const int *cols, int n_samples,
+                     const int *edges, int n_edges, unsigned char *pixel);
+int is_edge(double mu, double neighbour);
+void color_row(const color_table_t *table, const double *mu, int n, unsigned char *pixels);
+int color_index(const color_table_t *table, double mu);
+color_table_t *create_color_table(COLOR_PALETTE colors);
+void free_color_table(color_table_t *table);
+unsigned char **get_gradient_palette(unsigned char color1[3], unsigned char color2[3], int samples);
+unsigned char **create_palette(COLOR_PALETTE colors);
+int palette_size(COLOR_PALETTE colors);
+void free_palette(unsigned char **palette, COLOR_PALETTE colors);
+
+// misc
+double monotonic_seconds();
+
+
+/////////////
+// Globals //
+/////////////
+
+// escape kernels and the one in use
+extern escape_engine_t escape_engines[];
+extern escape_engine_t *escape_engine;
+
+// per frame counters
+extern frame_counters_t frame_counters;
+
+// kernels of the wider precision tiers per formula
+extern formula_kernels_t formula_kernels[];
+
+// names of PRECISION, COLOR_PALETTE and FORMULA values
+extern char *precision_names[];
+extern char *palette_names[];
+extern char *formula_names[];
+
+// render settings, set from the command line or menus
+extern PRECISION precision_override;
+extern FORMULA fractal_formula;
+extern coord_t julia_r;
+extern coord_t julia_i;
+extern int render_threads;
+extern render_pool_t *render_pool;
+extern int iteration_limit;
+extern int auto_iterations;
+extern int strict_render;
+extern tile_cache_t tile_cache;
+extern int tile_cache_megabytes;
+extern int mapped_export;
+extern int distance_render;
+extern double boundary_width;
+extern int antialias_samples;
+extern double antialias_threshold;
+extern cell_buffer_t export_cells;
+extern export_timings_t export_timings;
+
+#endif
@@ -4,34 +4,32 @@
 #include <ncurses.h>
 #include <form.h>
 #include <menu.h>
-#include <math.h>
 #include <string.h>
+#include <unistd.h>
 
-#define BARSIZE 21
-#define MAX_ITERATIONS 100
-
-///////////////////////////
-// Structure definitions //
-///////////////////////////
-typedef struct {
+#include "fractal.h"
 
-    long double a;
-    long double b;
+#define BARSIZE 21
 
-}complex_t;
+// side of the blocks sampled by the first progressive pass of the view, halved each pass
+#define PROGRESSIVE_BLOCK 8
 
-typedef struct {
+// frames listed in the render stats history
+#define STATS_HISTORY 8
 
-    long double min_x;
-    long double max_x;
+// characters shown by the number fields of the axes menu
+#define MENU_FIELD_WIDTH 15
 
-    long double min_y;
-    long double max_y;
+// info bar: first row below the axes, and the rows taken there by the key help, or by
+// the frame stats shown in its place. the kernel, precision, formula and limit follow
+#define INFO_BLOCK_ROW 8
+#define KEY_HELP_ROWS 8
+#define FRAME_STATS_ROWS 6
+#define STATUS_ROWS 4
 
-    int screen_height;
-    int screen_width;
-
-}window_t;
+///////////////////////////
+// Structure definitions //
+///////////////////////////
 
 typedef enum {
     LEFT,
@@ -42,46 +40,49 @@ typedef enum {
     ZOOM_IN
 }WINDOW_ACTION;
 
-typedef enum {
-    GOLDEN_PURPLE = 0,
-    PASTEL_RAINBOW = 1,
-    SCARLET_GRAY = 2,
-    OCEAN = 3,
-    EARTH = 4,
-    HIGHLIGHTERS = 5,
-    GRAY_SCALE = 6,
-    MATRIX = 7
-}COLOR_PALETTE;
+// one timed frame of the interactive view
+typedef struct {
+
+    double seconds;
+    long pixels;
+
+}frame_stats_t;
 
 //////////////////////////
 // Function definitions //
 //////////////////////////
 
-// mandelbrot functions
-complex_t complex_multiply(complex_t x, complex_t y);
-complex_t complex_add(complex_t x, complex_t y);
-complex_t complex_sub(complex_t x, complex_t y);
-long double complex_magnitude(complex_t x);
-complex_t scale(window_t display, int row, int column);
-double is_in_set(complex_t c);
-
 // ncurses functions
 void init_ncurses();
 void draw_info_bar(window_t display);
 void draw_fractal_window(WINDOW *fractal_window, window_t display);
+void paint_cells(WINDOW *fractal_window, const cell_buffer_t *cells, int step);
+void draw_progressive(WINDOW *fractal_window, cell_buffer_t *cells, window_t display);
+int draw_render_stats(double seconds, int row);
+int info_status_row();
 void move_window(WINDOW *fractal_window, window_t *display, WINDOW_ACTION action);
 void open_menu(window_t *display);
 void open_bitmap_menu(window_t *display);
 COLOR_PALETTE open_palette_menu(window_t *display);
-
-// bitmap functions
-void draw_bitmap(char *file_name, window_t display, int image_width, int image_height, COLOR_PALETTE colors);
-unsigned char **get_gradient_palette(unsigned char color1[3], unsigned char color2[3], int samples);
-unsigned char **create_palette(COLOR_PALETTE colors);
-void free_palette(unsigned char **palette, COLOR_PALETTE colors);
+FORMULA open_formula_menu(window_t *display);
 
 // misc
 void trim_string(char *string);
+void format_field(char *buffer, int decimals, long double value);
+
+
+/////////////
+// Globals //
+/////////////
+
+// cells of the interactive view, painted by draw_fractal_window
+cell_buffer_t view_cells = {0};
+
+// when set frames are timed and their stats shown in the info bar, with the last
+// few frames newest first
+int show_stats = FALSE;
+frame_stats_t stats_history[STATS_HISTORY];
+int stats_frames = 0;
 
 
 ///////////////////////////////////////
@@ -90,6 +91,119 @@ void trim_string(char *string);
 ///////////////////////////////////////
 int main(int argc, char **argv){
 
+    char *kernel_name = NULL;
+
+    // julia constant as read, coord_t has no scanf conversion
+    long double julia_constant[2];
+
+    // parse command line options
+    int opt;
+    while((opt = getopt(argc, argv, "k:t:p:i:a:A:b:f:J:sc:m")) != -1){
+        switch(opt){
+
+            // force a specific escape kernel
+            case 'k':
+                kernel_name = optarg;
+            break;
+
+            // number of render threads
+            case 't':
+                render_threads = atoi(optarg);
+            break;
+
+            // force a precision tier
+            case 'p':
+                for(precision_override = PRECISION_FLOAT; precision_override < PRECISION_AUTO; precision_override++){
+                    if(strcmp(optarg, precision_names[precision_override]) == 0){
+                        break;
+                    }
+                }
+                if(precision_override == PRECISION_AUTO){
+                    fprintf(stderr, "%s: unknown precision %s\n", argv[0], optarg);
+                    exit(1);
+                }
+            break;
+
+            // iteration limit, 0 or auto adapts it to the view
+            case 'i':
+                iteration_limit = atoi(optarg);
+            break;
+
+            // iterate every pixel instead of filling uniform rectangles
+            case 's':
+                strict_render = TRUE;
+            break;
+
+            // tile cache budget in megabytes, 0 turns it off
+            case 'c':
+                tile_cache_megabytes = atoi(optarg);
+            break;
+
+            // write exports through a memory mapping
+            case 'm':
+                mapped_export = TRUE;
+            break;
+
+            // samples per side of edge pixels in exports, and the escape value difference that marks them
+            case 'a':
+                antialias_samples = atoi(optarg);
+            break;
+
+            case 'A':
+                antialias_threshold = atof(optarg);
+            break;
+
+            // draw points closer to the set than this many pixels as part of it
+            case 'b':
+                distance_render = TRUE;
+                boundary_width = atof(optarg);
+            break;
+
+            // formula by name
+            case 'f':
+                for(fractal_formula = MANDELBROT; fractal_formula < FORMULAS; fractal_formula++){
+                    if(strcmp(optarg, formula_names[fractal_formula]) == 0){
+                        break;
+                    }
+                }
+                if(fractal_formula == FORMULAS){
+                    fprintf(stderr, "%s: unknown formula %s\n", argv[0], optarg);
+                    exit(1);
+                }
+            break;
+
+            // constant of the julia set as real,imaginary
+            case 'J':
+                if(sscanf(optarg, "%Lf,%Lf", &julia_constant[0], &julia_constant[1]) != 2){
+                    fprintf(stderr, "%s: julia constant must be real,imaginary\n", argv[0]);
+                    exit(1);
+                }
+                julia_r = julia_constant[0];
+                julia_i = julia_constant[1];
+            break;
+
+            default:
+                fprintf(stderr, "usage: %s [-k scalar|sse2|avx2|avx512] [-t threads] [-p float|double|extended|quad|perturb] [-i iterations|auto]\n"
+                                "       [-s] [-c megabytes] [-m] [-a samples] [-A threshold] [-b pixels]\n"
+                                "       [-f mandelbrot|julia|multibrot3|multibrot4|burning_ship] [-J real,imag]\n", argv[0]);
+                exit(1);
+
+        }
+    }
+
+    if(antialias_samples > ANTIALIAS_MAX_SAMPLES){
+        fprintf(stderr, "%s: at most %d antialiasing samples per side\n", argv[0], ANTIALIAS_MAX_SAMPLES);
+        exit(1);
+    }
+
+    // default to one render thread per cpu
+    if(render_threads < 1){
+        render_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    // pick fastest escape kernel supported by this cpu
+    init_escape_kernel(kernel_name);
+
     // initialize ncurses options
     init_ncurses();
 
@@ -104,6 +218,7 @@ int main(int argc, char **argv){
     display.max_y = 1;
     display.screen_height  = LINES - 2;
     display.screen_width = COLS-BARSIZE-2;
+    snap_window(&display);
 
 
     // draw info bar to left of fractal window
@@ -155,10 +270,45 @@ int main(int argc, char **argv){
                 move_window(fractal_window, &display, ZOOM_OUT);
             break;
 
+            // show or hide render stats
+            case 'r':
+
+                show_stats = !show_stats;
+                stats_frames = 0;
+                clear();
+
+                draw_info_bar(display);
+                draw_fractal_window(fractal_window, display);
+
+            break;
+
+            // draw boundaries from distance estimates, or stop
+            case 'b':
+
+                distance_render = !distance_render;
+
+                draw_info_bar(display);
+                draw_fractal_window(fractal_window, display);
+
+            break;
+
+            // pick the formula to draw
+            case 'f':
+
+                fractal_formula = open_formula_menu(&display);
+                clear();
+
+                // redraw display after menu closes
+                draw_info_bar(display);
+                draw_fractal_window(fractal_window, display);
+
+            break;
+
             // open axis menu
             case 'm':
 
                 open_menu(&display);
+                snap_window(&display);
                 clear();
 
                 // redraw display after menu closes
@@ -186,6 +336,7 @@ int main(int argc, char **argv){
 
                 display.screen_height  = LINES - 2;
                 display.screen_width = COLS-BARSIZE-2;
+                snap_window(&display);
 
                 wresize(fractal_window, LINES, COLS-BARSIZE);
 
@@ -203,8 +354,18 @@ int main(int argc, char **argv){
 
     }
 
-    // cleanly destroy window and exit program
+    // cleanly destroy window, stop render workers and exit program
     endwin();
+    if(render_pool != NULL){
+        render_pool_destroy(render_pool);
+    }
+    release_frame(&view_cells.frame);
+    free(view_cells.mu);
+    free(view_cells.known);
+    release_frame(&export_cells.frame);
+    free(export_cells.mu);
+    free(export_cells.known);
+    tile_cache_destroy();
     exit(1);
     
 }
@@ -244,19 +405,31 @@ void init_ncurses(){
 //////////////////////////////////////////////////////////////
 void draw_info_bar(window_t display){
 
+    // values are padded so shorter numbers overwrite longer ones
     mvprintw(0, 0, "Real Axis:");
-    mvprintw(1, 0, "  min: %.5Lf", display.min_x);
-    mvprintw(2, 0, "  max: %.5Lf", display.max_x);
+    mvprintw(1, 0, "  min: %-12.5Lf", (long double)display.min_x);
+    mvprintw(2, 0, "  max: %-12.5Lf", (long double)display.max_x);
 
     mvprintw(4, 0, "Imaginary Axis:");
-    mvprintw(5, 0, "  min: %.5Lf", display.min_y);
-    mvprintw(6, 0, "  max: %.5Lf", display.max_y);
+    mvprintw(5, 0, "  min: %-12.5Lf", (long double)display.min_y);
+    mvprintw(6, 0, "  max: %-12.5Lf", (long double)display.max_y);
+
+    // frame stats take the place of the key help, so they fit on a 24 line terminal
+    if(!show_stats){
+        mvprintw(INFO_BLOCK_ROW, 0, "w/s - pan up/down");
+        mvprintw(INFO_BLOCK_ROW + 1, 0, "a/d - pan left/right");
+        mvprintw(INFO_BLOCK_ROW + 2, 0, "e/q - zoom in/out");
+        mvprintw(INFO_BLOCK_ROW + 3, 0, "m - open axes menu");
+        mvprintw(INFO_BLOCK_ROW + 4, 0, "~ - export to bitmap");
+        mvprintw(INFO_BLOCK_ROW + 5, 0, "r - render stats");
+        mvprintw(INFO_BLOCK_ROW + 6, 0, "b - boundary %-3s", distance_render ? "on" : "off");
+        mvprintw(INFO_BLOCK_ROW + 7, 0, "f - formula");
+    }
 
-    mvprintw(8, 0, "w/s - pan up/down");
-    mvprintw(9, 0, "a/d - pan left/right");
-    mvprintw(10, 0, "e/q - zoom in/out");
-    mvprintw(11, 0, "m - open axes menu");
-    mvprintw(12, 0, "~ - export to bitmap");
+    int row = info_status_row();
+    mvprintw(row, 0, "kernel: %s", escape_engine->name);
+    mvprintw(row + 1, 0, "precision: %-8s", precision_names[choose_precision(display)]);
+    mvprintw(row + 2, 0, "formula: %-12s", formula_names[fractal_formula]);
 
 }
 
@@ -275,35 +448,201 @@ void draw_fractal_window(WINDOW *fractal_window, window_t display){
     //wborder(fractal_window, '|', '|', '-', '-', '+', '+', '+', '+');
     box(fractal_window, 0, 0);
 
-    // calculate color and print
-    int row, col;
-    for(row = 0; row < display.screen_height; row++){
-        for(col = 0; col < display.screen_width; col++){
+    // let the render pool fill the off-screen cell buffer, showing coarse passes on the way.
+    // the clock is only read when stats are shown
+    double start = show_stats ? monotonic_seconds() : 0;
+    draw_progressive(fractal_window, &view_cells, display);
+    double seconds = show_stats ? monotonic_seconds() - start : 0;
+
+    // tune the automatic limit for the next frame
+    adapt_iterations(&view_cells);
+    int row = info_status_row();
+    mvprintw(row + STATUS_ROWS - 1, 0, "limit: %-6d %-4s", view_cells.frame.iterations, iteration_limit > 0 ? "" : "auto");
+    row += STATUS_ROWS + 1;
+
+    if(show_stats){
+        row = draw_render_stats(seconds, row);
+    }
+
+    // the counters below only fit on taller terminals, a block is left out rather than cut.
+    // show how many cells were decided by each shortcut
+    if(row + 5 <= LINES){
+        mvprintw(row, 0, "Shortcuts (cells):");
+        mvprintw(row + 1, 0, "  cardioid: %-8ld", frame_counters.cardioid);
+        mvprintw(row + 2, 0, "  bulb: %-12ld", frame_counters.bulb);
+        mvprintw(row + 3, 0, "  periodic: %-8ld", frame_counters.periodic);
+        mvprintw(row + 4, 0, "  filled: %-10ld", frame_counters.filled);
+        row += 6;
+    }
+
+    // tile cache use since startup
+    if(row + 4 <= LINES){
+        mvprintw(row, 0, "Tile cache:");
+        mvprintw(row + 1, 0, "  hits: %-12ld", tile_cache.hits);
+        mvprintw(row + 2, 0, "  misses: %-10ld", tile_cache.misses);
+        mvprintw(row + 3, 0, "  used: %-8ld KB", (long)(tile_cache.used / 1024));
+    }
+
+    // coloring pass
+    paint_cells(fractal_window, &view_cells, 1);
+
+    refresh();
+    wrefresh(fractal_window);
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////
+// draw_render_stats:                                                     //
+//   add the frame that took seconds to the history and show its costs   //
+//   in place of the key help, with the history from row down as far as  //
+//   the terminal goes. returns the first row left free below it          //
+////////////////////////////////////////////////////////////////////////////
+int draw_render_stats(double seconds, int row){
+
+    // newest frame goes first
+    memmove(&stats_history[1], &stats_history[0], (STATS_HISTORY - 1) * sizeof(frame_stats_t));
+    stats_history[0].seconds = seconds;
+    stats_history[0].pixels = (long)view_cells.width * view_cells.height;
+
+    if(stats_frames < STATS_HISTORY){
+        stats_frames++;
+    }
+
+    // counters cover the cells computed for this frame, pixels/s the whole view
+    mvprintw(INFO_BLOCK_ROW, 0, "Frame (r to hide):");
+    mvprintw(INFO_BLOCK_ROW + 1, 0, "  time: %-9.1f ms", seconds * 1e3);
+    mvprintw(INFO_BLOCK_ROW + 2, 0, "  Mpx/s: %-12.2f", stats_history[0].pixels / seconds / 1e6);
+    mvprintw(INFO_BLOCK_ROW + 3, 0, "  iters: %-12ld", frame_counters.iterations);
+    mvprintw(INFO_BLOCK_ROW + 4, 0, "  escaped: %-10ld", frame_counters.escaped);
+    mvprintw(INFO_BLOCK_ROW + 5, 0, "  at limit: %-9ld", frame_counters.exhausted);
 
-            // use screen coordinate to find corresponding number on complex plane
-            complex_t c = scale(display, row, col);
+    // as many frames as fit, the rows of frames not timed yet are kept so the blocks
+    // below don't move while the history fills up
+    int shown = LINES - row - 1;
+
+    if(shown > STATS_HISTORY){
+        shown = STATS_HISTORY;
+    }
+
+    if(shown < 1){
+        return row;
+    }
 
-            // get normalized escape value
-            double mu = is_in_set(c);
+    mvprintw(row, 0, "History (ms, Mpx/s):");
 
-            // if not 0, point is not in set, find color
-            if(mu != 0){
+    int k;
+    for(k = 0; k < shown; k++){
+
+        if(k < stats_frames){
+            mvprintw(row + 1 + k, 0, "  %8.1f %9.2f", stats_history[k].seconds * 1e3,
+                     stats_history[k].pixels / stats_history[k].seconds / 1e6);
+        }else{
+            mvprintw(row + 1 + k, 0, "%-20s", "");
+        }
+
+    }
+
+    return row + shown + 2;
+
+}
 
-                // get normalized escape to be between 1 and 6 for ncurses colors
-                int color_num = (int)floor(mu) % 6 + 1;
 
-                // turn on color, write X, and turn off color
-                wattron(fractal_window, COLOR_PAIR(color_num));
-                mvwprintw(fractal_window, row+1, col+1, "X");
-                wattroff(fractal_window, COLOR_PAIR(color_num));
 
+/////////////////////////////////////////////////////////////////
+// info_status_row:                                            //
+//   row of the info bar the kernel, precision, formula and   //
+//   limit start at, below the key help or the frame stats    //
+/////////////////////////////////////////////////////////////////
+int info_status_row(){
+
+    return INFO_BLOCK_ROW + (show_stats ? FRAME_STATS_ROWS : KEY_HELP_ROWS) + 1;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////
+// paint_cells:                                                  //
+//   map the escape values of the cells to ncurses color pairs. //
+//   only every step-th cell is read, each one painting a block  //
+//   of step by step cells                                       //
+///////////////////////////////////////////////////////////////////
+void paint_cells(WINDOW *fractal_window, const cell_buffer_t *cells, int step){
+
+    int row, col, block_row, block_col;
+    for(row = 0; row < cells->height; row += step){
+        for(col = 0; col < cells->width; col += step){
+
+            double mu = cells->mu[row * cells->width + col];
+
+            // get normalized escape to be between 1 and 6 for ncurses colors
+            int color_num = (int)floor(mu) % 6 + 1;
+
+            for(block_row = row; block_row < row + step && block_row < cells->height; block_row++){
+                for(block_col = col; block_col < col + step && block_col < cells->width; block_col++){
+
+                    // if not 0, point is not in set, turn on color, write X, and turn off color
+                    if(mu != 0){
+                        wattron(fractal_window, COLOR_PAIR(color_num));
+                        mvwprintw(fractal_window, block_row+1, block_col+1, "X");
+                        wattroff(fractal_window, COLOR_PAIR(color_num));
+                    }else{
+                        mvwprintw(fractal_window, block_row+1, block_col+1, " ");
+                    }
+
+                }
             }
-    
+
         }
     }
 
-    refresh();
-    wrefresh(fractal_window);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw_progressive:                                                         //
+//   compute the cells of display. a view that isn't a pan or in the cache  //
+//   is first sampled in blocks of PROGRESSIVE_BLOCK cells, then blocks     //
+//   half as big, with the screen updated after each pass. the full pass    //
+//   at the end reuses every sample                                          //
+///////////////////////////////////////////////////////////////////////////////
+void draw_progressive(WINDOW *fractal_window, cell_buffer_t *cells, window_t display){
+
+    if(shift_cells(cells, display)){
+        return;
+    }
+
+    reset_cells(cells, display);
+
+    // nothing to show early when the cache already has the whole view
+    tile_area_t whole;
+    init_tile_area(&whole, &cells->frame, 0, 0, cells->height, cells->width);
+
+    if(!area_cached(&cells->frame, &whole)){
+
+        memset(cells->known, 0, (size_t)cells->width * cells->height);
+
+        progressive_pass_t pass;
+        pass.cells = cells;
+
+        for(pass.step = PROGRESSIVE_BLOCK; pass.step > 1; pass.step /= 2){
+
+            render_pool_run(get_render_pool(), sample_row, &pass, (cells->height + pass.step - 1) / pass.step);
+
+            paint_cells(fractal_window, cells, pass.step);
+            wrefresh(fractal_window);
+
+        }
+
+        cells->seeded = TRUE;
+
+    }
+
+    compute_cell_area(cells, 0, 0, cells->height, cells->width);
+    cells->seeded = FALSE;
 
 }
 
@@ -315,11 +654,11 @@ void draw_fractal_window(WINDOW *fractal_window, window_t display){
 void move_window(WINDOW *fractal_window, window_t *display, WINDOW_ACTION action){
 
     // calculate number of units on complex planes corresponding to the width and height of one character
-    long double x_cursor_units = (display->max_x - display->min_x)/display->screen_width;
-    long double y_cursor_units = (display->max_y - display->min_y)/display->screen_height;
+    coord_t x_cursor_units = (display->max_x - display->min_x)/display->screen_width;
+    coord_t y_cursor_units = (display->max_y - display->min_y)/display->screen_height;
 
     // used in aspect ratio calculations when zooming
-    long double x_length, y_length, x_diff, aspect;
+    coord_t x_length, y_length, x_diff, aspect;
 
     switch(action){
 
@@ -386,7 +725,11 @@ void move_window(WINDOW *fractal_window, window_t *display, WINDOW_ACTION action
 
     }
 
+    // keep cells on a grid that pans without drifting
+    snap_window(display);
+
     // redraw info bar and fractal window
+    draw_info_bar(*display);
     draw_fractal_window(fractal_window, *display);
 
 }
@@ -401,43 +744,59 @@ void open_menu(window_t *display){
 
     // create ncurses window and form pointers
     WINDOW* menu_win = newwin(10, 50, 5, 5);
-    FIELD *fields[5];
+    FIELD *fields[8];
     FORM *form;
     int ch, rows, cols;
 
     // define necessary fields and terminating NULL field
-    fields[0] = new_field(1, 15, 1, 9, 0, 0);
-    fields[1] = new_field(1, 15, 2, 9, 0, 0);
-    fields[2] = new_field(1, 15, 5, 9, 0, 0);
-    fields[3] = new_field(1, 15, 6, 9, 0, 0);
-    fields[4] = NULL;
+    fields[0] = new_field(1, MENU_FIELD_WIDTH, 1, 9, 0, 0);
+    fields[1] = new_field(1, MENU_FIELD_WIDTH, 2, 9, 0, 0);
+    fields[2] = new_field(1, MENU_FIELD_WIDTH, 5, 9, 0, 0);
+    fields[3] = new_field(1, MENU_FIELD_WIDTH, 6, 9, 0, 0);
+    fields[4] = new_field(1, MENU_FIELD_WIDTH, 9, 9, 0, 0);
+    fields[5] = new_field(1, MENU_FIELD_WIDTH, 12, 9, 0, 0);
+    fields[6] = new_field(1, MENU_FIELD_WIDTH, 13, 9, 0, 0);
+    fields[7] = NULL;
 
     // set field options
     int i;
-    for(i = 0; i < 4; i++){
+    for(i = 0; i < 7; i++){
 
         set_field_back(fields[i], A_UNDERLINE); // underline field
         field_opts_off(fields[i], O_AUTOSKIP);  // don't move to next field when full
 
     }
 
-    // create string buffers for grabbing current display parameters
-    char *real_min_string = malloc(15*sizeof(char));
-    char *real_max_string = malloc(15*sizeof(char));
-    char *imag_min_string = malloc(15*sizeof(char));
-    char *imag_max_string = malloc(15*sizeof(char));
+    // string buffers for grabbing current display parameters, one character per field cell
+    char real_min_string[MENU_FIELD_WIDTH + 1];
+    char real_max_string[MENU_FIELD_WIDTH + 1];
+    char imag_min_string[MENU_FIELD_WIDTH + 1];
+    char imag_max_string[MENU_FIELD_WIDTH + 1];
+    char iterations_string[MENU_FIELD_WIDTH + 1];
+    char julia_r_string[MENU_FIELD_WIDTH + 1];
+    char julia_i_string[MENU_FIELD_WIDTH + 1];
 
     // read current display paramters
-    sprintf(real_min_string, "%.5Lf", display->min_x);
-    sprintf(real_max_string, "%.5Lf", display->max_x);
-    sprintf(imag_min_string, "%.5LF", display->min_y);
-    sprintf(imag_max_string, "%.5LF", display->max_y);
+    format_field(real_min_string, 5, (long double)display->min_x);
+    format_field(real_max_string, 5, (long double)display->max_x);
+    format_field(imag_min_string, 5, (long double)display->min_y);
+    format_field(imag_max_string, 5, (long double)display->max_y);
+    if(iteration_limit > 0){
+        snprintf(iterations_string, sizeof(iterations_string), "%d", iteration_limit);
+    }else{
+        snprintf(iterations_string, sizeof(iterations_string), "auto");
+    }
+    format_field(julia_r_string, 10, (long double)julia_r);
+    format_field(julia_i_string, 10, (long double)julia_i);
 
     // write current display parameters to corresponding fields
     set_field_buffer(fields[0], 0, real_min_string);
     set_field_buffer(fields[1], 0, real_max_string);
     set_field_buffer(fields[2], 0, imag_min_string);
     set_field_buffer(fields[3], 0, imag_max_string);
+    set_field_buffer(fields[4], 0, iterations_string);
+    set_field_buffer(fields[5], 0, julia_r_string);
+    set_field_buffer(fields[6], 0, julia_i_string);
 
     // create form using defined fields
     form = new_form(fields);
@@ -475,8 +834,15 @@ void open_menu(window_t *display){
     mvwprintw(menu_win, 6, 5, "min: ");
     mvwprintw(menu_win, 7, 5, "max: ");
 
+    mvwprintw(menu_win, 9, 3, "Iterations (0 = auto):");
+    mvwprintw(menu_win, 10, 5, "max: ");
+
+    mvwprintw(menu_win, 12, 3, "Julia Constant:");
+    mvwprintw(menu_win, 13, 5, "re:  ");
+    mvwprintw(menu_win, 14, 5, "im:  ");
+
     // write instructions to bottom of menu window
-    mvwprintw(menu_win, 9, 2, "m to confirm | ESC to cancel");
+    mvwprintw(menu_win, 16, 2, "m to confirm | ESC to cancel");
     
     // refresh menu window
     wrefresh(menu_win);
@@ -528,10 +894,28 @@ void open_menu(window_t *display){
             case 'm':
                 form_driver(form, REQ_VALIDATION);
 
-                display->min_x = atof(field_buffer(fields[0], 0));
-                display->max_x = atof(field_buffer(fields[1], 0));
-                display->min_y = atof(field_buffer(fields[2], 0));
-                display->max_y = atof(field_buffer(fields[3], 0));
+                // fields only show a few digits, keep the full value of the ones left alone
+                if(field_status(fields[0])){
+                    display->min_x = strtold(field_buffer(fields[0], 0), NULL);
+                }
+                if(field_status(fields[1])){
+                    display->max_x = strtold(field_buffer(fields[1], 0), NULL);
+                }
+                if(field_status(fields[2])){
+                    display->min_y = strtold(field_buffer(fields[2], 0), NULL);
+                }
+                if(field_status(fields[3])){
+                    display->max_y = strtold(field_buffer(fields[3], 0), NULL);
+                }
+                if(field_status(fields[4])){
+                    iteration_limit = atoi(field_buffer(fields[4], 0));
+                }
+                if(field_status(fields[5])){
+                    julia_r = strtold(field_buffer(fields[5], 0), NULL);
+                }
+                if(field_status(fields[6])){
+                    julia_i = strtold(field_buffer(fields[6], 0), NULL);
+                }
 
                 done = TRUE;
 
@@ -564,10 +948,9 @@ void open_menu(window_t *display){
     free_field(fields[1]);
     free_field(fields[2]);
     free_field(fields[3]);
-    free(real_min_string);
-    free(real_max_string);
-    free(imag_min_string);
-    free(imag_max_string);
+    free_field(fields[4]);
+    free_field(fields[5]);
+    free_field(fields[6]);
     delwin(menu_win);
     
 }
@@ -897,691 +1280,112 @@ COLOR_PALETTE open_palette_menu(window_t *display){
 }
 
 
-/////////////////////////////////////////////////////////////////////////
-// complex_multiply:                                                   //
-//   multiply two complex_t numbers and return the resulting complex_t //
-/////////////////////////////////////////////////////////////////////////
-complex_t complex_multiply(complex_t x, complex_t y){
-
-    complex_t result;
-
-    result.a = (x.a * y.a) - (x.b * y.b);
-    result.b = (x.a * y.b) + (y.a * x.b);
-
-    return result;
-
-}
-
-
-
-/////////////////////////////////////////////////////////////////////////
-// complex_add:                                                        //
-//   add two complex_t numbers and return the resulting complex_t      //
-/////////////////////////////////////////////////////////////////////////
-complex_t complex_add(complex_t x, complex_t y){
-
-    complex_t result;
-
-    result.a = x.a + y.a;
-    result.b = x.b + y.b;
-
-    return result;
-
-}
-
-
-
-///////////////////////////////////////////////////////////////////////////////////
-// complex_sub:                                                                  //
-//   subtract one complex_t from another and return the resulting complex_t      //
-///////////////////////////////////////////////////////////////////////////////////
-complex_t complex_sub(complex_t x, complex_t y){
-
-    complex_t result;
-
-    result.a = x.a - y.a;
-    result.b = x.b - y.b;
-
-    return result;
-
-}
-
-
-
-///////////////////////////////////////////
-// complex_magnitude:                    //
-//   return the magnitude of a complex_t //
-///////////////////////////////////////////
-long double complex_magnitude(complex_t x){
-
-    long double result = sqrt(x.a * x.a + x.b * x.b);
-
-    return result;
-
-}
-
-
-
 //////////////////////////////////////////////////////////////////////////
-// complex_scale:                                                       //
-//   return the complex_t corresponding to the given cursor coordinates //
+// open_formula_menu:                                                   //
+//   open menu for user to pick the formula drawn, starting on the one  //
+//   drawn now. returns FORMULA enum corresponding to user choice       //
 //////////////////////////////////////////////////////////////////////////
-complex_t scale(window_t display, int row, int col){
-
-    // window coords include border so subtract from row and column values to get actual coord on plane
-    int actual_x = col;
-    int actual_y = row;
-
-    complex_t c;
-
-    // calculate number of complex units corresponding to one cursor width or height
-    long double x_cursor_units = (display.max_x - display.min_x)/display.screen_width;
-    long double y_cursor_units = (display.max_y - display.min_y)/display.screen_height;
-
-    // calculate position on complex plane relative to position on display
-    c.a = display.min_x + (actual_x * x_cursor_units);
-    c.b = display.max_y - (actual_y * y_cursor_units);
-
-    return c;
-
-}
-
-
-
-///////////////////////////////////////////////////////////////////////////////
-// is_in_set:                                                                //
-//   return 0 if complex_t c is in the mandelbrot set and mu, a normalized   //
-//   valued related to the escape time of the recursive function             //
-//   this is used in calculating the color of each coordinate                //
-///////////////////////////////////////////////////////////////////////////////
-double is_in_set(complex_t c){
-
-    // initial z set to 0
-    complex_t z;    
-    z.a = 0;
-    z.b = 0;
-
-    // set escape radius to 2
-    double escape_r = 2.0;
-    double mu;
+FORMULA open_formula_menu(window_t *display){
 
-    // i is iterations completed
-    int i = 0;
-    while(i <= MAX_ITERATIONS){
-
-        // iterate z value and store result
-        z = complex_add(complex_multiply(z, z), c);
-
-        // increment iteration counter
-        i++;
-        double mag = complex_magnitude(z);
-
-        // if mag is greater than escape radius point is not in set, end loop
-        if (mag > escape_r){
-            break;
-        }
-    }
-
-    // if c is in set calculate mu, normalized escape value
-    if(i < MAX_ITERATIONS){
-
-        // complete a couple more iterations of z to get cleaner mu value
-        z = complex_add(complex_multiply(z, z), c);
-        i++;
-        z = complex_add(complex_multiply(z, z), c);
-        i++;
-           
-        double mag = complex_magnitude(z);
-        mu = i - ( log( log(mag) ) / log(2.0) );
-
-        // handle occasional NaN results from calculation
-        if(isnan(mu)){
-            mu = 0;
-        }
-
-        // handle negative mu values
-        if(mu < 0){
-            mu *= -1;
-        }
-
-    }else{
-
-        // else set mu to exactly zero
-        mu = 0;
-
-    }
-
-    return mu;
-
-}
-
-
-
-//////////////////////////////////////////////////////////////////////////////////////////////////////////
-// draw_bitmap:                                                                                         //
-//   using current fractal display values, construct a bitmap of the specified width and height using a //
-//   defined color palette and save it to the given file name                                           //
-//////////////////////////////////////////////////////////////////////////////////////////////////////////
-void draw_bitmap(char *file_name, window_t display, int image_width, int image_height, COLOR_PALETTE colors){
-
-    // define new window to use with scale() function
-    window_t bitmap_window;
-
-    // use axis values from display
-    bitmap_window.min_x = display.min_x;
-    bitmap_window.max_x = display.max_x;
-    bitmap_window.min_y = display.min_y;
-    bitmap_window.max_y = display.max_y;
-
-    // use image height and width for window height/width
-    bitmap_window.screen_height = image_height;
-    bitmap_window.screen_width = image_width;
-
-
-    // open file for writing
-    FILE *image;
-    image = fopen(file_name, "wb");
-
-    // detect a failure to open file
-    if(image == NULL){
-        printf("error opening file for writing\n");
-        exit(1);
-    }
-
-    // calculate number of bytes per row and necessary number of padding bytes for bitmap
-    int bytes_per_row = (((24 * bitmap_window.screen_width) + 31) / 32) * 4;
-    int padding_bytes = bytes_per_row - (bitmap_window.screen_width * 3);
-
-    // write BMP header
-    char id[2] = {'B', 'M'};
-    int size = bytes_per_row * bitmap_window.screen_height;
-    short reserved = 0;
-    int offset = 26;
-
-    fwrite(id, 1, 2, image);
-    fwrite(&size, 4, 1, image);
-    fwrite(&reserved, 2, 2, image);
-    fwrite(&offset, 4, 1, image);
-
-    // write BITMAPCOREHEADER
-    int header_size = 12;
-    short width = bitmap_window.screen_width;
-    short height = bitmap_window.screen_height;
-    short color_planes = 1;
-    short bpp = 24;
-
-    fwrite(&header_size, 4, 1, image);
-    fwrite(&width, 2, 1, image);
-    fwrite(&height, 2, 1, image);
-    fwrite(&color_planes, 2, 1, image);
-    fwrite(&bpp, 2, 1, image);
-
-    unsigned char **palette = create_palette(colors);
-    
-    // calculate whether pixel is in set and it's color
-    int row, col;
-    for(row = bitmap_window.screen_height - 1; row >= 0; row--){
-        for(col = 0; col < bitmap_window.screen_width; col++){
-
-            // scale pixel location to position on complex plane
-            complex_t c = scale(bitmap_window, row, col);
-
-            // get mu value for c
-            double mu = is_in_set(c);
-
-            // if not zero c is not in set so calculate color
-            if(mu != 0){
-
-                // get index for two adjacent colors in palette relating to mu
-                // palettes are of different sizes so different modulo operators are necessary
-                int color1, color2;
-                switch(colors){
-
-                    // 8 color palettes
-                    case GOLDEN_PURPLE:
-                    case SCARLET_GRAY:
-                    case GRAY_SCALE:
-                    case MATRIX:
-
-                        color1 = (int)floor(mu) % 8;
-                        color2 = ((int)floor(mu) + 1) % 8;
-
-                    break;
-
-                    // 9 color palettes
-                    case OCEAN:
-
-                        color1 = (int)floor(mu) % 9;
-                        color2 = ((int)floor(mu) + 1) % 9;
-
-                    break;
-
-                    // 12 color palettes
-                    case PASTEL_RAINBOW:
-                    case EARTH:
-                    case HIGHLIGHTERS:
-
-                        color1 = (int)floor(mu) % 12;
-                        color2 = ((int)floor(mu)+1) % 12;
-
-                    break;
-
-                }
-
-                // get final pixel color by linear interpolation between palette values
-                double blue = palette[color1][0] + ((palette[color2][0]-palette[color1][0]) * (mu-floor(mu)));
-                double green = palette[color1][1] + ((palette[color2][1]-palette[color1][1]) * (mu-floor(mu)));
-                double red = palette[color1][2] + ((palette[color2][2]-palette[color1][2]) * (mu-floor(mu)));
-                unsigned char b = round(blue);
-                unsigned char g = round(green);
-                unsigned char r = round(red);
-                char color[] = {b, g, r};
-
-                // write pixel to image using calculated color
-                fwrite(&color, 1, 3, image);
-
-            }else{ // c is in set, draw black
-                char black[] = {0, 0, 0};
-                fwrite(&black, 1, 3, image);
-            }
-        }
-
-        // write padding zeros to each row to reach 4 byte boundaries
-        unsigned char zero = 0x0;
-        fwrite(&zero, 1, padding_bytes, image);
-
-    }
-
-
-    // free color palette memory and close file
-    free_palette(palette, colors);
-    fclose(image);
-}
-
-
-
-/////////////////////////////////////////////////////////////////////////////////////////////////////////
-// get_gradient_palette:
-//   given two RGB color values as char arrays linearly interpolate *samples* amount of colors between //
-//   them resulting in a gradient                                                                      //
-/////////////////////////////////////////////////////////////////////////////////////////////////////////
-unsigned char **get_gradient_palette(unsigned char color1[3], unsigned char color2[3], int samples){
-
-    // define palette
-    unsigned char **palette;
-
-    // allocate memory for palette
-    palette = malloc(samples * sizeof(unsigned char*));
-
-    // check for successful allocation, exit on failure
-    if(palette == NULL){
+    // define ncurses objects
+    WINDOW *formula_window;
+    ITEM **formula_items;
+    MENU *formula_menu;
+    FORMULA formula;
+    int ch, done;
 
-        printf("error allocating memory for gradeent palette\n");
-        exit(1);
+    // formula choices, in FORMULA order
+    char *choices[FORMULAS] = {
+        "Mandelbrot",
+        "Julia",
+        "Multibrot z^3",
+        "Multibrot z^4",
+        "Burning Ship"
+    };
 
-    }
+    // allocate memory for menu items and the NULL item ending them
+    formula_items = malloc((FORMULAS+1) * sizeof(ITEM *));
 
     int i;
-    for(i = 0; i < samples; i++){
-
-        // allocate memory for each RGB color
-        palette[i] = malloc(3 * sizeof(unsigned char));
-
-        // check for successful allocation and exit on failure
-        if(palette[i] == NULL){
-
-            printf("error allocating memory for color\n");
-            exit(1);
-
-        }
-
-        // percent difference between first and second color
-        double progress = (1.0/samples) * i;
-
-        // calculate RGB values based on progress
-        double blue = color1[0] + ((color2[0] - color1[0]) * progress);
-        double green = color1[1] + ((color2[1] - color1[1]) * progress);
-        double red = color1[2] + ((color2[2] - color1[2]) * progress);
-        unsigned char b = round(blue);
-        unsigned char g = round(green);
-        unsigned char r = round(red);
-
-        // define color in memory
-        palette[i][0] = b;
-        palette[i][1] = g;
-        palette[i][2] = r;
+    for(i = 0; i < FORMULAS; i++){
+        formula_items[i] = new_item(choices[i], "");
     }
+    formula_items[i] = NULL;
 
-    return palette;
-
-}
-
-
-
-////////////////////////////////////////////////////////////////////////////
-// create_palette:                                                        //
-//   create a color palette corresponding to the given COLOR_PALETTE enum //
-////////////////////////////////////////////////////////////////////////////
-unsigned char **create_palette(COLOR_PALETTE colors){
-
-    // GOLDEN_PURPLE colors
-    unsigned char gp_purple[] = {0x72, 0x02, 0x61};
-    unsigned char gp_gold[] = {0x1b, 0x80, 0x99};
-    unsigned char gp_blue[] = {0x88, 0x5e, 0x06};
-
-    // PASTEL_RAINBOW colors
-    unsigned char pr_blue[] = {0x6a, 0x4e, 0x23};
-    unsigned char pr_green[] = {0x31, 0x80, 0x26};
-    unsigned char pr_yellow[] = {0x30, 0x72, 0xa5};
-    unsigned char pr_red[] = {0x30, 0x36, 0xa5};
-
-    // SCARLET_GRAY colors
-    unsigned char sg_red[] = {0x0, 0x0, 0xbb};
-    unsigned char sg_gray[] = {0x66, 0x66, 0x66};
-    unsigned char sg_white[] = {0xff, 0xff, 0xff};
-
-    // OCEAN colors
-    unsigned char o_lightgreen[] = {0x29, 0xd4, 0x9f};
-    unsigned char o_bluegreen[] = {0x5d, 0x94, 0x14};
-    unsigned char o_turquoise[] = {0x4d, 0x67, 0x0b};
-    unsigned char o_marine[] = {0x43, 0x45, 0x0a};
-
-    // EARTH colors
-    unsigned char e_darkgreen[] = {0x00, 0x4d, 0x33};
-    unsigned char e_lightgreen[] = {0x18, 0x9e, 0x90};
-    unsigned char e_beige[] = {0x74, 0x85, 0xa1};
-    unsigned char e_brown[] = {0x2a, 0x43, 0x77};
-
-    // HIGHLIGHTERS colors
-    unsigned char h_yellow[] = {0x15, 0xf3, 0xf3};
-    unsigned char h_green[] = {0x2c, 0xf5, 0x83};
-    unsigned char h_pink[] = {0x99, 0x00, 0xff};
-    unsigned char h_purple[] = {0xd0, 0x0d, 0x6e};
-
-    // GRAY_SCALE colors
-    unsigned char gs_white[] = {0xff, 0xff, 0xff};
-    unsigned char gs_gray[] = {0x33, 0x33, 0x33};
-
-    // MATRIX colors
-    unsigned char m_green1[] = {0x48, 0xe1, 0x02};
-    unsigned char m_green2[] = {0x13, 0x62, 0x08};
-    unsigned char m_green3[] = {0x0b, 0x4a, 0x04};
-
-    // final palette to be returned
-    unsigned char **palette;
-
-    // gradient palettes to be combined
-    unsigned char **palette1;
-    unsigned char **palette2;
-    unsigned char **palette3;
-
-    // for array indexing later
-    int i;
-    
-
-    // construct palette
-    switch(colors){
-
-        case GOLDEN_PURPLE:
-
-            // allocate palette memory
-            palette = malloc(8 * sizeof(unsigned char*));
-
-            // check for successful allocation, exit on failure
-            if(palette == NULL){
-                printf("error allocating memory for palette\n");
-                exit(1);
-            }
-            
-            // get intermediate gradients between colors
-            palette1 = get_gradient_palette(gp_gold, gp_purple, 4);
-            palette2 = get_gradient_palette(gp_purple, gp_blue, 4);
-
-            // put gradients into final palette
-            for(i=0; i < 4; i++){
-
-                palette[i] = palette1[i];
-                palette[i+4] = palette2[i];
-
-            }
-
-        break;
-
-        case PASTEL_RAINBOW:
-
-            // allocate palette memory
-            palette = malloc(12 * sizeof(unsigned char*));
-
-            // check for successful allocation, exit on failure
-            if(palette == NULL){
-                printf("error allocating memory for palette\n");
-                exit(1);
-            }
-
-            // get intermediate gradients between colors
-            palette1 = get_gradient_palette(pr_blue, pr_red, 4);
-            palette2 = get_gradient_palette(pr_red, pr_yellow, 4);
-            palette3 = get_gradient_palette(pr_yellow, pr_green, 4);
-
-            // put gradients into final palette
-            for(i = 0; i < 4; i++){
-
-                palette[i] = palette1[i];
-                palette[i+4] = palette2[i];
-                palette[i+8] = palette3[i];
-
-            }
-
-        break;
-
-        case SCARLET_GRAY:
-
-            // allocate palette memory
-            palette = malloc(8 * sizeof(unsigned char*));
-
-            // check for successful allocation, exit on failure
-            if(palette == NULL){
-                printf("error allocating memory for palette\n");
-                exit(1);
-            }
-
-
-            // get intermediate gradients between colors
-            palette1 = get_gradient_palette(sg_gray, sg_red, 4);
-            palette2 = get_gradient_palette(sg_red, sg_white, 4);
+    // create menu and its window
+    formula_menu = new_menu(formula_items);
+    formula_window = newwin(11, 26, (LINES/2)-5, (COLS/2)-13);
+    keypad(formula_window, TRUE);
 
-            // put gradients into final palette
-            for(i=0; i < 4; i++){
+    set_menu_win(formula_menu, formula_window);
+    set_menu_sub(formula_menu, derwin(formula_window, FORMULAS, 18, 4, 3));
+    set_menu_mark(formula_menu, ">");
 
-                palette[i] = palette1[i];
-                palette[i+4] = palette2[i];
-
-            }
-
-        break;
-
-        case OCEAN:
-
-            // allocate palette memory
-            palette = malloc(9 * sizeof(unsigned char*));
-
-            // check for successful allocation, exit on failure
-            if(palette == NULL){
-                printf("error allocating memory for palette\n");
-                exit(1);
-            }
-
-
-            // get intermediate gradients between colors
-            palette1 = get_gradient_palette(o_lightgreen, o_bluegreen, 3);
-            palette2 = get_gradient_palette(o_bluegreen, o_turquoise, 3);
-            palette3 = get_gradient_palette(o_turquoise, o_marine, 3);
-
-            // put gradients into final palette
-            for(i = 0; i < 3; i++){
-
-                palette[i] = palette1[i];
-                palette[i+3] = palette2[i];
-                palette[i+6] = palette3[i];
-
-            }
-
-        break;
-
-        case EARTH:
-
-            // allocate palette memory
-            palette = malloc(12 * sizeof(unsigned char*));
-
-            // check for successful allocation, exit on failure
-            if(palette == NULL){
-                printf("error allocating memory for palette\n");
-                exit(1);
-            }
-
-
-            // get intermediate gradients between colors
-            palette1 = get_gradient_palette(e_beige, e_brown, 4);
-            palette2 = get_gradient_palette(e_brown, e_lightgreen, 4);
-            palette3 = get_gradient_palette(e_lightgreen, e_darkgreen, 4);
-
-            // put gradients into final palette
-            for(i = 0; i < 4; i++){
-
-                palette[i] = palette1[i];
-                palette[i+4] = palette2[i];
-                palette[i+8] = palette3[i];
-
-            }
-
-        break;
-
-        case HIGHLIGHTERS:
-
-            // allocate palette memory
-            palette = malloc(12 * sizeof(unsigned char*));
-
-            // check for successful allocation, exit on failure
-            if(palette == NULL){
-                printf("error allocating memory for palette\n");
-                exit(1);
-            }
-
-
-            // get intermediate gradients between colors
-            palette1 = get_gradient_palette(h_green, h_yellow, 4);
-            palette2 = get_gradient_palette(h_yellow, h_pink, 4);
-            palette3 = get_gradient_palette(h_pink, h_purple, 4);
-
-            // put gradients into final palette
-            for(i = 0; i < 4; i++){
-
-                palette[i] = palette1[i];
-                palette[i+4] = palette2[i];
-                palette[i+8] = palette3[i];
-
-            }
-
-        break;
-
-        case GRAY_SCALE:
-
-            // get gradient between gray and white
-            palette = get_gradient_palette(gs_white, gs_gray, 8);
+    box(formula_window, 0, 0);
+    refresh();
 
-        break;
+    mvwprintw(formula_window, 1, 2, "Choose a formula");
 
-        case MATRIX:
+    // post menu with the current formula highlighted
+    post_menu(formula_menu);
+    set_current_item(formula_menu, formula_items[fractal_formula]);
+    wrefresh(formula_window);
 
-            // allocate palette memory
-            palette = malloc(8 * sizeof(unsigned char*));
+    // grab input until enter or escape is pressed, escape keeps the current formula
+    formula = fractal_formula;
+    done = FALSE;
+    while(!done){
+        ch = wgetch(formula_window);
+        switch(ch){
 
-            // check for successful allocation, exit on failure
-            if(palette == NULL){
-                printf("error allocating memory for palette\n");
-                exit(1);
-            }
+            // move selection down
+            case KEY_DOWN:
+                menu_driver(formula_menu, REQ_DOWN_ITEM);
+            break;
 
+            // move selection up
+            case KEY_UP:
+                menu_driver(formula_menu, REQ_UP_ITEM);
+            break;
 
-            // get intermediate gradients between colors
-            palette1 = get_gradient_palette(m_green3, m_green2, 4);
-            palette2 = get_gradient_palette(m_green2, m_green1, 4);
+            // select currently highlighted item
+            case '\n':
+                formula = item_index(current_item(formula_menu));
+                done = TRUE;
+            break;
 
-            // put gradients into final palette
-            for(i = 0; i < 4; i++){
+            // capture ascii code for escape key
+            case 27:
+                done = TRUE;
+            break;
 
-                palette[i] = palette1[i];
-                palette[i+4] = palette2[i];
+            // handle terminal resize event
+            case KEY_RESIZE:
 
-            }
+                display->screen_height = LINES - 2;
+                display->screen_width = COLS - BARSIZE - 2;
 
-        break;
+            break;
 
+        }
+        wrefresh(formula_window);
     }
-    
-
-    palette1 = NULL;
-    palette2 = NULL;
-    palette3 = NULL;
-    return palette;
-
-}
-
-
-
-////////////////////////////////////
-// free_palette:                  //
-//   free memory in given palette //
-////////////////////////////////////
-void free_palette(unsigned char **palette, COLOR_PALETTE colors){
-
-    int i;
-
-    // free memory based on palette enum
-    switch(colors){
-
-        // 8 color palettes
-        case GOLDEN_PURPLE:
-        case SCARLET_GRAY:
-        case GRAY_SCALE:
-        case MATRIX:
-
-            for(i = 0; i < 8; i++){
-                free(palette[i]);
-            }
-
-        break;
-
-        // 9 color palettes
-        case OCEAN:
-
-            for(i = 0; i < 9; i++){
-                free(palette[i]);
-            }
-
-
-        break;
-
-
-        // 12 color palettes
-        case PASTEL_RAINBOW:
-        case EARTH:
-        case HIGHLIGHTERS:
-
-            for(i = 0; i < 12; i++){
-                free(palette[i]);
-            }
-
-        break;
 
+    // clean up ncurses memory
+    unpost_menu(formula_menu);
+    free_menu(formula_menu);
+    for(i = 0; i < FORMULAS; i++){
+        free_item(formula_items[i]);
     }
+    free(formula_items);
+    delwin(formula_window);
 
-    free(palette);
+    refresh();
 
+    return formula;
 }
 
 
-
 ////////////////////////////////////////////
 // trim_string:                           //
 //   trim trailing whitespace from string //
@@ -1598,3 +1402,23 @@ void trim_string(char *string){
     }
 
 }
+
+
+
+/////////////////////////////////////////////////////////////////////
+// format_field:                                                   //
+//   write value with the given decimals into buffer, which holds //
+//   MENU_FIELD_WIDTH characters. values too long for the field   //
+//   are written in exponent form so no digit before the point    //
+//   is cut off                                                    //
+/////////////////////////////////////////////////////////////////////
+void format_field(char *buffer, int decimals, long double value){
+
+    int length = snprintf(buffer, MENU_FIELD_WIDTH + 1, "%.*Lf", decimals, value);
+
+    // sign, one digit, point and an exponent of up to "e-4951" take 9 characters
+    if(length > MENU_FIELD_WIDTH){
+        snprintf(buffer, MENU_FIELD_WIDTH + 1, "%.*Le", MENU_FIELD_WIDTH - 9, value);
+    }
+
+}
@@ -0,0 +1,1803 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#include "fractal.h"
+
+// default image size and width of the real axis shown around a center
+#define DEFAULT_IMAGE_WIDTH 1920
+#define DEFAULT_IMAGE_HEIGHT 1080
+#define DEFAULT_SCALE 3
+
+// width of the preview the automatic iteration limit is tuned on, and how many
+// preview frames it gets to settle
+#define SETTLE_WIDTH 160
+#define SETTLE_FRAMES 8
+
+// zoom sequences compute one keyframe per halving of the scale, at this many times the
+// frame resolution per side, so every frame down to half its scale can be resampled from it
+#define KEYFRAME_OVERSAMPLE 2
+
+// distributed exports: tag sent ahead of the image so workers reject other input, pixels
+// per band handed to a worker, and the fewest bands per worker so fast workers can take
+// over from slow ones
+#define FARM_MAGIC "MBF1"
+#define FARM_BAND_PIXELS (1 << 20)
+#define FARM_BANDS_PER_WORKER 4
+
+// how many times longer than the average band a band has to run before an idle worker
+// computes it too, and how many times a failed worker is restarted before it is given up
+// on. workers only fail by exiting or sending something else, or by running past the
+// band timeout of -T when one is given. deep bands can take any time, slow ones are
+// only ever duplicated
+#define FARM_SLOW_FACTOR 4
+#define FARM_RESTARTS 2
+
+///////////////////////////
+// Structure definitions //
+///////////////////////////
+
+// keyframe of a zoom sequence, colored at KEYFRAME_OVERSAMPLE times the frame resolution
+// (level 0) and averaged down to the frame resolution (level 1). pixels are BGR, top row first
+typedef struct {
+
+    cell_buffer_t cells;
+    int index;
+
+    unsigned char *pixels[2];
+    int width[2];
+    int height[2];
+
+    color_table_t *table;
+
+}keyframe_t;
+
+// keyframe pixels on either side of each frame column or row, and the weight of the
+// second one out of 256. column taps are byte offsets into a keyframe row
+typedef struct {
+
+    int *first;
+    int *second;
+    int *weight;
+
+}resample_taps_t;
+
+// frame of a zoom sequence being resampled from a keyframe by the workers
+typedef struct {
+
+    const keyframe_t *key;
+    unsigned char *pixels;
+    int width;
+
+    // taps into each keyframe level, and the weight of level 1 out of 256
+    resample_taps_t columns[2];
+    resample_taps_t rows[2];
+    int level_mix;
+
+}sequence_frame_t;
+
+// band of rows of an exponential map being computed by the workers
+typedef struct {
+
+    frame_t frame;
+    int width;
+
+    // radius of map row 0, and the cosine and sine of every column's angle
+    long double outer_radius;
+    const double *cosines;
+    const double *sines;
+
+    color_table_t *table;
+
+    // band pixel rows in file order, bottom row first, including padding
+    unsigned char *pixels;
+    int bytes_per_row;
+
+    int first_row;
+    int rows;
+
+}map_band_t;
+
+// image of a distributed export, sent to every worker before its first band. coordinates
+// are sent as raw coord_t, so workers need the same byte order and float formats
+typedef struct {
+
+    char magic[4];
+    window_t display;
+    int iterations;
+    int precision;
+    int palette;
+
+    int formula;
+    coord_t julia_r;
+    coord_t julia_i;
+
+    int distance_render;
+    double boundary_width;
+    int antialias_samples;
+    double antialias_threshold;
+    int strict_render;
+
+}farm_image_t;
+
+// band of image rows handed to a worker. the worker replies with the same header
+// followed by the band's pixel rows in file order, bottom row first, including padding
+typedef struct {
+
+    int first_row;
+    int rows;
+
+}farm_job_t;
+
+// worker process of a distributed export, run from a shell command or as a local
+// mandelbrot-render -W when command is NULL
+typedef struct {
+
+    char *command;
+    pid_t pid;
+    int to_worker;
+    int from_worker;
+    int alive;
+    int restarts;
+
+    // band being computed, -1 when idle, and the reply read so far
+    int band;
+    double started;
+    unsigned char *reply;
+    size_t received;
+
+}farm_worker_t;
+
+// distributed export being assembled. bands are done once one copy came back, and
+// have copies running on that many workers
+typedef struct {
+
+    farm_image_t image;
+    int fd;
+    int bytes_per_row;
+
+    farm_worker_t *workers;
+    int n_workers;
+    const char *kernel_name;
+    int worker_threads;
+
+    // seconds a worker gets for one band before it is restarted, 0 for no limit
+    int timeout;
+
+    int band_rows;
+    int n_bands;
+    int *done;
+    int *copies;
+    double *started;
+    int remaining;
+
+    // time taken by the bands done so far, and how many bands went to a second worker
+    double band_seconds;
+    int bands_timed;
+    int resent;
+
+}farm_t;
+
+//////////////////////////
+// Function definitions //
+//////////////////////////
+
+void usage(char *program);
+int settle_iterations(window_t display);
+
+// zoom sequences
+void render_sequence(char *pattern, coord_t center_x, coord_t center_y, long double start_scale,
+                     long double end_scale, int frames, int width, int height, COLOR_PALETTE palette);
+void render_keyframe(keyframe_t *key, coord_t center_x, coord_t center_y, long double key_scale, int width, int height);
+void color_keyframe_row(void *context, int row);
+void shrink_keyframe_row(void *context, int row);
+void resample_frame_row(void *context, int row);
+void alloc_resample_taps(resample_taps_t *taps, int n);
+void set_resample_taps(resample_taps_t *taps, int n, double origin, double step, int size, int stride);
+void free_resample_taps(resample_taps_t *taps);
+
+// exponential maps
+void render_exponential_map(char *file_name, coord_t center_x, coord_t center_y, long double outer_radius,
+                            long double inner_radius, int width, COLOR_PALETTE palette);
+void exponential_map_row(void *context, int row);
+
+// distributed exports
+void render_distributed(char *file_name, window_t display, COLOR_PALETTE palette, const char *kernel_name,
+                        int local_workers, char **commands, int n_commands, int timeout);
+void start_farm_worker(farm_t *farm, farm_worker_t *worker);
+void stop_farm_worker(farm_worker_t *worker, int force);
+void fail_farm_worker(farm_t *farm, farm_worker_t *worker, const char *reason);
+void send_farm_band(farm_t *farm, farm_worker_t *worker, int band);
+int next_farm_band(const farm_t *farm, double now);
+int read_farm_reply(farm_t *farm, farm_worker_t *worker);
+void run_farm_worker();
+int read_full(int fd, void *buffer, size_t size);
+int write_full(int fd, const void *buffer, size_t size);
+
+
+///////////////////////////////////////////////////////////////////////
+// main:                                                             //
+//   render one bitmap from command line arguments, without ncurses //
+///////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv){
+
+    char *kernel_name = NULL;
+    char *file_name = NULL;
+    int image_width = DEFAULT_IMAGE_WIDTH;
+    int image_height = DEFAULT_IMAGE_HEIGHT;
+    COLOR_PALETTE palette = GOLDEN_PURPLE;
+
+    // viewport given as bounds, or as a center and the width of the real axis
+    long double bounds[4];
+    long double center_x = -0.5, center_y = 0, scale = DEFAULT_SCALE;
+    int have_bounds = FALSE;
+
+    // zoom sequence from scale to end_scale, off with a single frame
+    int frames = 1;
+    long double end_scale = 0;
+
+    // exponential map from radius scale down to end_scale instead of an image
+    int exponential_map = FALSE;
+
+    // distributed export over local workers and worker commands, or a worker of one
+    int local_workers = 0;
+    char **commands = NULL;
+    int n_commands = 0;
+    int band_timeout = 0;
+    int farm_worker = FALSE;
+
+    // julia constant as read, coord_t has no scanf conversion
+    long double julia_constant[2];
+
+    // parse command line options
+    int opt;
+    while((opt = getopt(argc, argv, "o:w:h:v:C:z:n:Z:EP:f:J:i:a:A:b:k:t:p:sc:mj:x:T:W")) != -1){
+        switch(opt){
+
+            // output bitmap
+            case 'o':
+                file_name = optarg;
+            break;
+
+            // image size in pixels
+            case 'w':
+                image_width = atoi(optarg);
+            break;
+
+            case 'h':
+                image_height = atoi(optarg);
+            break;
+
+            // min_x,max_x,min_y,max_y
+            case 'v':
+                if(sscanf(optarg, "%Lf,%Lf,%Lf,%Lf", &bounds[0], &bounds[1], &bounds[2], &bounds[3]) != 4){
+                    usage(argv[0]);
+                }
+                have_bounds = TRUE;
+            break;
+
+            // center as real,imaginary
+            case 'C':
+                if(sscanf(optarg, "%Lf,%Lf", &center_x, &center_y) != 2){
+                    usage(argv[0]);
+                }
+            break;
+
+            // width of the real axis around the center
+            case 'z':
+                scale = strtold(optarg, NULL);
+            break;
+
+            // number of frames of a zoom sequence and the scale it ends at
+            case 'n':
+                frames = atoi(optarg);
+            break;
+
+            case 'Z':
+                end_scale = strtold(optarg, NULL);
+            break;
+
+            // log-polar strip for mandelbrot-unwrap, -w is its number of angles
+            case 'E':
+                exponential_map = TRUE;
+            break;
+
+            // palette by name
+            case 'P':
+                for(palette = GOLDEN_PURPLE; palette <= MATRIX; palette++){
+                    if(strcmp(optarg, palette_names[palette]) == 0){
+                        break;
+                    }
+                }
+                if(palette > MATRIX){
+                    usage(argv[0]);
+                }
+            break;
+
+            // formula by name
+            case 'f':
+                for(fractal_formula = MANDELBROT; fractal_formula < FORMULAS; fractal_formula++){
+                    if(strcmp(optarg, formula_names[fractal_formula]) == 0){
+                        break;
+                    }
+                }
+                if(fractal_formula == FORMULAS){
+                    usage(argv[0]);
+                }
+            break;
+
+            // constant of the julia set as real,imaginary
+            case 'J':
+                if(sscanf(optarg, "%Lf,%Lf", &julia_constant[0], &julia_constant[1]) != 2){
+                    usage(argv[0]);
+                }
+                julia_r = julia_constant[0];
+                julia_i = julia_constant[1];
+            break;
+
+            // iteration limit, 0 or auto adapts it to the view
+            case 'i':
+                iteration_limit = atoi(optarg);
+            break;
+
+            // samples per side of edge pixels, and the escape value difference that marks them
+            case 'a':
+                antialias_samples = atoi(optarg);
+            break;
+
+            case 'A':
+                antialias_threshold = atof(optarg);
+            break;
+
+            // draw points closer to the set than this many pixels as part of it
+            case 'b':
+                distance_render = TRUE;
+                boundary_width = atof(optarg);
+            break;
+
+            // force a specific escape kernel
+            case 'k':
+                kernel_name = optarg;
+            break;
+
+            // number of render threads
+            case 't':
+                render_threads = atoi(optarg);
+            break;
+
+            // force a precision tier
+            case 'p':
+                for(precision_override = PRECISION_FLOAT; precision_override < PRECISION_AUTO; precision_override++){
+                    if(strcmp(optarg, precision_names[precision_override]) == 0){
+                        break;
+                    }
+                }
+                if(precision_override == PRECISION_AUTO){
+                    usage(argv[0]);
+                }
+            break;
+
+            // iterate every pixel instead of filling uniform rectangles
+            case 's':
+                strict_render = TRUE;
+            break;
+
+            // tile cache budget in megabytes, 0 turns it off
+            case 'c':
+                tile_cache_megabytes = atoi(optarg);
+            break;
+
+            // write the export through a memory mapping
+            case 'm':
+                mapped_export = TRUE;
+            break;
+
+            // split the export into bands rendered by this many local worker processes
+            case 'j':
+                local_workers = atoi(optarg);
+            break;
+
+            // and by a worker started with a shell command, such as one over ssh
+            case 'x':
+                commands = realloc(commands, (n_commands + 1) * sizeof(char *));
+                if(commands == NULL){
+                    fprintf(stderr, "error allocating memory for worker commands\n");
+                    exit(1);
+                }
+                commands[n_commands++] = optarg;
+            break;
+
+            // seconds a worker gets for one band before it is restarted, none by default
+            case 'T':
+                band_timeout = atoi(optarg);
+            break;
+
+            // render bands of a distributed export from stdin to stdout
+            case 'W':
+                farm_worker = TRUE;
+            break;
+
+            default:
+                usage(argv[0]);
+
+        }
+    }
+
+    // workers get their image from the coordinator, only the kernel and threads are their own
+    if(farm_worker){
+
+        if(render_threads < 1){
+            render_threads = sysconf(_SC_NPROCESSORS_ONLN);
+        }
+
+        init_escape_kernel(kernel_name);
+        run_farm_worker();
+
+        if(render_pool != NULL){
+            render_pool_destroy(render_pool);
+        }
+        tile_cache_destroy();
+        return 0;
+
+    }
+
+    if(file_name == NULL || image_width < 1 || image_height < 1 || scale <= 0 || frames < 1 ||
+       antialias_samples > ANTIALIAS_MAX_SAMPLES){
+        usage(argv[0]);
+    }
+
+    // sequences are given by a center and name their frames with a printf pattern, or
+    // stream them to stdout with -
+    if(exponential_map && (have_bounds || frames > 1 || end_scale <= 0 || end_scale >= scale)){
+        usage(argv[0]);
+    }
+
+    // distributed exports are single bitmaps
+    if(local_workers < 0 || band_timeout < 0 || ((local_workers > 0 || n_commands > 0) && (frames > 1 || exponential_map))){
+        usage(argv[0]);
+    }
+
+    if(frames > 1 && (have_bounds || end_scale <= 0 ||
+                      (strcmp(file_name, "-") != 0 && strchr(file_name, '%') == NULL))){
+        usage(argv[0]);
+    }
+
+    // default to one render thread per cpu
+    if(render_threads < 1){
+        render_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    // pick fastest escape kernel supported by this cpu
+    init_escape_kernel(kernel_name);
+
+    if(exponential_map){
+
+        render_exponential_map(file_name, center_x, center_y, scale, end_scale, image_width, palette);
+        tile_cache_destroy();
+        return 0;
+
+    }
+
+    if(frames > 1){
+
+        render_sequence(file_name, center_x, center_y, scale, end_scale, frames,
+                        image_width, image_height, palette);
+        tile_cache_destroy();
+        return 0;
+
+    }
+
+    window_t display;
+    display.screen_width = image_width;
+    display.screen_height = image_height;
+
+    if(have_bounds){
+
+        display.min_x = bounds[0];
+        display.max_x = bounds[1];
+        display.min_y = bounds[2];
+        display.max_y = bounds[3];
+
+    }else{
+
+        // imaginary axis follows the image's aspect ratio. edges are found in quad
+        // precision, deep scales vanish next to the center in long double
+        coord_t half_width = (coord_t)scale / 2;
+        coord_t half_height = half_width * image_height / image_width;
+        display.min_x = (coord_t)center_x - half_width;
+        display.max_x = (coord_t)center_x + half_width;
+        display.min_y = (coord_t)center_y - half_height;
+        display.max_y = (coord_t)center_y + half_height;
+
+    }
+
+    if(display.max_x <= display.min_x || display.max_y <= display.min_y){
+        usage(argv[0]);
+    }
+
+    double start = monotonic_seconds();
+
+    // there is no previous frame to adapt the automatic limit to, tune it on a preview
+    int iterations = settle_iterations(display);
+    double settle_time = monotonic_seconds() - start;
+
+    if(local_workers > 0 || n_commands > 0){
+
+        render_distributed(file_name, display, palette, kernel_name, local_workers, commands, n_commands, band_timeout);
+        free(commands);
+        tile_cache_destroy();
+        return 0;
+
+    }
+
+    start = monotonic_seconds();
+    draw_bitmap(file_name, display, image_width, image_height, palette);
+    double render_time = monotonic_seconds() - start;
+
+    double pixels = (double)image_width * image_height;
+
+    printf("%s: %dx%d, %s palette, %s precision, %d iterations%s, %s kernel, %d threads\n",
+           file_name, image_width, image_height, palette_names[palette],
+           precision_names[choose_precision(display)],
+           iterations, iteration_limit > 0 ? "" : " (auto)", escape_engine->name, render_threads);
+    printf("settle %.3f s, render %.3f s, %.2f Mpixel/s\n",
+           settle_time, render_time, pixels / render_time / 1e6);
+
+    // stop render workers and free what the export kept
+    if(render_pool != NULL){
+        render_pool_destroy(render_pool);
+    }
+    release_frame(&export_cells.frame);
+    free(export_cells.mu);
+    free(export_cells.known);
+    tile_cache_destroy();
+
+    return 0;
+
+}
+
+
+
+////////////////////////////////////////////////
+// usage:                                     //
+//   print command line options and exit      //
+////////////////////////////////////////////////
+void usage(char *program){
+
+    fprintf(stderr, "usage: %s -o file.bmp [-w width] [-h height]\n"
+                    "       [-v min_x,max_x,min_y,max_y | -C real,imag [-z scale] [-n frames -Z end_scale | -E -Z end_scale]]\n"
+                    "       [-P golden_purple|pastel_rainbow|scarlet_gray|ocean|earth|highlighters|gray_scale|matrix]\n"
+                    "       [-f mandelbrot|julia|multibrot3|multibrot4|burning_ship] [-J real,imag]\n"
+                    "       [-i iterations|auto] [-a samples] [-A threshold] [-b pixels] [-k scalar|sse2|avx2|avx512]\n"
+                    "       [-t threads] [-p float|double|extended|quad|perturb] [-s] [-c megabytes] [-m]\n"
+                    "       [-j workers] [-x worker_command]... [-T band_timeout]\n"
+                    "       %s -W [-k scalar|sse2|avx2|avx512] [-t threads]\n", program, program);
+    exit(1);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// settle_iterations:                                                        //
+//   with the automatic limit, render a small preview of display until      //
+//   adapt_iterations stops changing the limit. returns the limit the       //
+//   export will use                                                         //
+///////////////////////////////////////////////////////////////////////////////
+int settle_iterations(window_t display){
+
+    if(iteration_limit > 0){
+        return iteration_limit;
+    }
+
+    // preview keeps the image's aspect ratio
+    window_t preview_window = display;
+    preview_window.screen_width = SETTLE_WIDTH;
+    preview_window.screen_height = (long)SETTLE_WIDTH * display.screen_height / display.screen_width;
+
+    if(preview_window.screen_height < 1){
+        preview_window.screen_height = 1;
+    }
+
+    snap_window(&preview_window);
+
+    cell_buffer_t preview = {0};
+
+    int frame;
+    for(frame = 0; frame < SETTLE_FRAMES; frame++){
+
+        compute_cells(&preview, preview_window);
+        adapt_iterations(&preview);
+
+        if(choose_iterations(preview_window) == preview.frame.iterations){
+            break;
+        }
+
+    }
+
+    release_frame(&preview.frame);
+    free(preview.mu);
+    free(preview.known);
+
+    return choose_iterations(display);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// render_sequence:                                                          //
+//   zoom on the center from start_scale to end_scale in the given number   //
+//   of frames, named by pattern or streamed to stdout as raw BGR when      //
+//   pattern is -. only one keyframe is computed per halving of the scale, //
+//   frames are resampled from it                                            //
+///////////////////////////////////////////////////////////////////////////////
+void render_sequence(char *pattern, coord_t center_x, coord_t center_y, long double start_scale,
+                     long double end_scale, int frames, int width, int height, COLOR_PALETTE palette){
+
+    // keyframe k is 2^-k times as wide as the widest frame
+    long double widest = start_scale > end_scale ? start_scale : end_scale;
+
+    keyframe_t key = {0};
+    key.index = -1;
+    key.table = create_color_table(palette);
+
+    sequence_frame_t frame;
+    frame.key = &key;
+    frame.width = width;
+    frame.pixels = malloc((size_t)width * height * 3);
+
+    if(frame.pixels == NULL){
+        fprintf(stderr, "error allocating memory for sequence frame\n");
+        exit(1);
+    }
+
+    int level;
+    for(level = 0; level < 2; level++){
+        alloc_resample_taps(&frame.columns[level], width);
+        alloc_resample_taps(&frame.rows[level], height);
+    }
+
+    render_pool_t *pool = get_render_pool();
+    double compute_time = 0, resample_time = 0, start;
+    int keyframes = 0;
+
+    int f;
+    for(f = 0; f < frames; f++){
+
+        // scales step by a constant ratio so the zoom looks steady
+        long double frame_scale = start_scale * powl(end_scale / start_scale, (long double)f / (frames - 1));
+        int index = (int)floorl(log2l(widest / frame_scale));
+
+        if(index < 0){
+            index = 0;
+        }
+
+        if(index != key.index){
+
+            start = monotonic_seconds();
+            render_keyframe(&key, center_x, center_y, ldexpl(widest, -index), width, height);
+            compute_time += monotonic_seconds() - start;
+
+            key.index = index;
+            keyframes++;
+
+        }
+
+        start = monotonic_seconds();
+
+        // place the frame on the keyframe's grid, offsets are taken in quad precision since
+        // both windows are tiny next to their coordinates on deep zooms
+        window_t key_window = key.cells.frame.display;
+        coord_t key_dx = (key_window.max_x - key_window.min_x) / key_window.screen_width;
+        coord_t key_dy = (key_window.max_y - key_window.min_y) / key_window.screen_height;
+        coord_t frame_dx = (coord_t)frame_scale / width;
+
+        double origin_x = (double)((center_x - frame_dx * width / 2 - key_window.min_x) / key_dx);
+        double origin_y = (double)((key_window.max_y - (center_y + frame_dx * height / 2)) / key_dy);
+        double step_x = (double)(frame_dx / key_dx);
+        double step_y = (double)(frame_dx / key_dy);
+
+        // level 1 pixel i averages the level 0 pixels around KEYFRAME_OVERSAMPLE * i + (KEYFRAME_OVERSAMPLE - 1) / 2
+        double shift = (KEYFRAME_OVERSAMPLE - 1) / 2.0;
+
+        for(level = 0; level < 2; level++){
+
+            int factor = level == 0 ? 1 : KEYFRAME_OVERSAMPLE;
+            double offset = level == 0 ? 0 : shift;
+
+            set_resample_taps(&frame.columns[level], width, (origin_x - offset) / factor, step_x / factor,
+                              key.width[level], 3);
+            set_resample_taps(&frame.rows[level], height, (origin_y - offset) / factor, step_y / factor,
+                              key.height[level], 1);
+
+        }
+
+        // level 1 pixels are KEYFRAME_OVERSAMPLE level 0 pixels wide
+        double mix = log2(step_x) / log2(KEYFRAME_OVERSAMPLE);
+        frame.level_mix = mix < 0 ? 0 : mix > 1 ? 256 : (int)(mix * 256 + 0.5);
+
+        render_pool_run(pool, resample_frame_row, &frame, height);
+        resample_time += monotonic_seconds() - start;
+
+        write_frame(pattern, f, frame.pixels, width, height);
+
+    }
+
+    // stdout may be carrying the frames
+    fprintf(stderr, "%d frames, %d keyframes (%.1f%% of the pixels of every frame), compute %.3f s, resample %.3f s\n",
+            frames, keyframes, 100.0 * keyframes * KEYFRAME_OVERSAMPLE * KEYFRAME_OVERSAMPLE / frames,
+            compute_time, resample_time);
+
+    if(render_pool != NULL){
+        render_pool_destroy(render_pool);
+    }
+
+    release_frame(&key.cells.frame);
+    free(key.cells.mu);
+    free(key.cells.known);
+    free(key.pixels[0]);
+    free(key.pixels[1]);
+    free_color_table(key.table);
+    free(frame.pixels);
+
+    for(level = 0; level < 2; level++){
+        free_resample_taps(&frame.columns[level]);
+        free_resample_taps(&frame.rows[level]);
+    }
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////
+// render_keyframe:                                                       //
+//   compute the keyframe key_scale wide around the center and color both //
+//   of its levels for frames of width x height                           //
+////////////////////////////////////////////////////////////////////////////
+void render_keyframe(keyframe_t *key, coord_t center_x, coord_t center_y, long double key_scale, int width, int height){
+
+    window_t display;
+    display.screen_width = width * KEYFRAME_OVERSAMPLE;
+    display.screen_height = height * KEYFRAME_OVERSAMPLE;
+
+    coord_t half_width = (coord_t)key_scale / 2;
+    coord_t half_height = half_width * height / width;
+    display.min_x = center_x - half_width;
+    display.max_x = center_x + half_width;
+    display.min_y = center_y - half_height;
+    display.max_y = center_y + half_height;
+
+    snap_window(&display);
+
+    // the first keyframe has no previous one to adapt the automatic limit to
+    if(key->index < 0){
+        settle_iterations(display);
+    }
+
+    compute_cells(&key->cells, display);
+    adapt_iterations(&key->cells);
+
+    int level;
+    for(level = 0; level < 2; level++){
+
+        if(key->pixels[level] == NULL){
+
+            key->width[level] = level == 0 ? display.screen_width : width;
+            key->height[level] = level == 0 ? display.screen_height : height;
+            key->pixels[level] = malloc((size_t)key->width[level] * key->height[level] * 3);
+
+            if(key->pixels[level] == NULL){
+                fprintf(stderr, "error allocating memory for keyframe\n");
+                exit(1);
+            }
+
+        }
+
+    }
+
+    render_pool_t *pool = get_render_pool();
+    render_pool_run(pool, color_keyframe_row, key, key->height[0]);
+    render_pool_run(pool, shrink_keyframe_row, key, key->height[1]);
+
+}
+
+
+
+//////////////////////////////////////////////////////////
+// color_keyframe_row:                                  //
+//   color one row of keyframe level 0, called by workers //
+//////////////////////////////////////////////////////////
+void color_keyframe_row(void *context, int row){
+
+    keyframe_t *key = context;
+
+    const double *mu = key->cells.mu + (size_t)row * key->width[0];
+    unsigned char *pixel = key->pixels[0] + (size_t)row * key->width[0] * 3;
+
+    color_row(key->table, mu, key->width[0], pixel);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////
+// shrink_keyframe_row:                                          //
+//   average level 0 into one row of keyframe level 1, called by //
+//   workers                                                     //
+///////////////////////////////////////////////////////////////////
+void shrink_keyframe_row(void *context, int row){
+
+    keyframe_t *key = context;
+
+    int samples = KEYFRAME_OVERSAMPLE * KEYFRAME_OVERSAMPLE;
+    unsigned char *pixel = key->pixels[1] + (size_t)row * key->width[1] * 3;
+
+    int col, channel, i, j;
+    for(col = 0; col < key->width[1]; col++){
+        for(channel = 0; channel < 3; channel++){
+
+            int sum = 0;
+
+            for(i = 0; i < KEYFRAME_OVERSAMPLE; i++){
+
+                const unsigned char *source = key->pixels[0] +
+                    ((size_t)(row * KEYFRAME_OVERSAMPLE + i) * key->width[0] + col * KEYFRAME_OVERSAMPLE) * 3;
+
+                for(j = 0; j < KEYFRAME_OVERSAMPLE; j++){
+                    sum += source[j * 3 + channel];
+                }
+
+            }
+
+            pixel[col * 3 + channel] = (sum + samples / 2) / samples;
+
+        }
+    }
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// resample_frame_row:                                                //
+//   fill one row of the frame from both keyframe levels, blended by  //
+//   how close the frame's scale is to each, called by workers       //
+////////////////////////////////////////////////////////////////////////
+void resample_frame_row(void *context, int row){
+
+    sequence_frame_t *frame = context;
+    const keyframe_t *key = frame->key;
+
+    unsigned char *pixel = frame->pixels + (size_t)row * frame->width * 3;
+
+    // fixed point throughout, every frame of a sequence goes through here
+    const unsigned char *top[2], *bottom[2];
+    int row_weight[2];
+
+    int level;
+    for(level = 0; level < 2; level++){
+
+        size_t bytes_per_row = (size_t)key->width[level] * 3;
+        top[level] = key->pixels[level] + frame->rows[level].first[row] * bytes_per_row;
+        bottom[level] = key->pixels[level] + frame->rows[level].second[row] * bytes_per_row;
+        row_weight[level] = frame->rows[level].weight[row];
+
+    }
+
+    int col, channel;
+    for(col = 0; col < frame->width; col++){
+
+        int color[2][3];
+
+        for(level = 0; level < 2; level++){
+
+            int left = frame->columns[level].first[col];
+            int right = frame->columns[level].second[col];
+            int weight = frame->columns[level].weight[col];
+
+            for(channel = 0; channel < 3; channel++){
+
+                int upper = top[level][left + channel] * (256 - weight) + top[level][right + channel] * weight;
+                int lower = bottom[level][left + channel] * (256 - weight) + bottom[level][right + channel] * weight;
+                color[level][channel] = upper * (256 - row_weight[level]) + lower * row_weight[level];
+
+            }
+
+        }
+
+        // colors are scaled by 2^16 here, and by 2^8 more once the levels are blended
+        for(channel = 0; channel < 3; channel++){
+            pixel[col * 3 + channel] = ((long)color[0][channel] * (256 - frame->level_mix) +
+                                        (long)color[1][channel] * frame->level_mix + (1L << 23)) >> 24;
+        }
+
+    }
+
+}
+
+
+
+//////////////////////////////////////////////////////
+// alloc_resample_taps:                             //
+//   make room for the taps of n columns or rows    //
+//////////////////////////////////////////////////////
+void alloc_resample_taps(resample_taps_t *taps, int n){
+
+    taps->first = malloc(n * sizeof(int));
+    taps->second = malloc(n * sizeof(int));
+    taps->weight = malloc(n * sizeof(int));
+
+    if(taps->first == NULL || taps->second == NULL || taps->weight == NULL){
+        fprintf(stderr, "error allocating memory for resampling\n");
+        exit(1);
+    }
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////
+// set_resample_taps:                                                      //
+//   taps of n frame columns or rows starting at keyframe position origin //
+//   and step keyframe pixels apart, in a level size pixels across.       //
+//   positions past the edges take the nearest edge pixel                 //
+/////////////////////////////////////////////////////////////////////////////
+void set_resample_taps(resample_taps_t *taps, int n, double origin, double step, int size, int stride){
+
+    int i;
+    for(i = 0; i < n; i++){
+
+        double position = origin + i * step;
+        position = position < 0 ? 0 : position > size - 1 ? size - 1 : position;
+
+        int first = (int)position;
+        taps->first[i] = first * stride;
+        taps->second[i] = (first + 1 < size ? first + 1 : first) * stride;
+        taps->weight[i] = (int)((position - first) * 256 + 0.5);
+
+    }
+
+}
+
+
+
+////////////////////////////////////
+// free_resample_taps:            //
+//   free what alloc_resample_taps made //
+////////////////////////////////////
+void free_resample_taps(resample_taps_t *taps){
+
+    free(taps->first);
+    free(taps->second);
+    free(taps->weight);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// render_exponential_map:                                                   //
+//   write the log-polar strip around the center as a bitmap width columns  //
+//   wide. column i is the angle 2 pi i / width and row j the radius        //
+//   outer_radius * e^(-2 pi j / width), so map pixels are square and each  //
+//   row is one scale step. rows continue until inner_radius is reached.    //
+//   bands are computed from the innermost one up, in file order            //
+///////////////////////////////////////////////////////////////////////////////
+void render_exponential_map(char *file_name, coord_t center_x, coord_t center_y, long double outer_radius,
+                            long double inner_radius, int width, COLOR_PALETTE palette){
+
+    int height = (int)ceill(logl(outer_radius / inner_radius) * width / (2 * M_PI)) + 1;
+
+    map_band_t band;
+    band.width = width;
+    band.outer_radius = outer_radius;
+    band.table = create_color_table(palette);
+    band.bytes_per_row = (((24 * width) + 31) / 32) * 4;
+
+    // bands cover at most one halving of the radius, so each one gets the precision and
+    // iteration limit of a frame at its depth
+    int band_height = BAND_PIXELS / width;
+    int octave_rows = (int)(width * M_LN2 / (2 * M_PI));
+
+    if(band_height > octave_rows){
+        band_height = octave_rows;
+    }
+
+    if(band_height < 1){
+        band_height = 1;
+    }
+
+    if(band_height > height){
+        band_height = height;
+    }
+
+    double *cosines = malloc(width * sizeof(double));
+    double *sines = malloc(width * sizeof(double));
+    band.pixels = calloc((size_t)band_height * band.bytes_per_row, 1);
+
+    if(cosines == NULL || sines == NULL || band.pixels == NULL){
+        printf("error allocating memory for exponential map\n");
+        exit(1);
+    }
+
+    int col;
+    for(col = 0; col < width; col++){
+        cosines[col] = cos(2 * M_PI * col / width);
+        sines[col] = sin(2 * M_PI * col / width);
+    }
+
+    band.cosines = cosines;
+    band.sines = sines;
+
+    FILE *image = fopen(file_name, "wb");
+
+    if(image == NULL){
+        printf("error opening file for writing\n");
+        exit(1);
+    }
+
+    unsigned char header[BITMAP_HEADER_SIZE];
+    fill_bitmap_header(header, width, height, band.bytes_per_row);
+    fwrite(header, 1, BITMAP_HEADER_SIZE, image);
+
+    render_pool_t *pool = get_render_pool();
+    double start = monotonic_seconds();
+
+    int band_end;
+    for(band_end = height; band_end > 0; band_end -= band_height){
+
+        band.first_row = band_end - band_height < 0 ? 0 : band_end - band_height;
+        band.rows = band_end - band.first_row;
+
+        // a window reaching the band's outer radius, with pixels as far apart as the
+        // band's points are along its inner radius, picks the precision and limit
+        long double outer = outer_radius * expl(-2 * M_PI * band.first_row / width);
+        long double inner = outer_radius * expl(-2 * M_PI * (band_end - 1) / width);
+        int side = (int)ceill(width * outer / (M_PI * inner));
+
+        window_t display;
+        display.min_x = center_x - (coord_t)outer;
+        display.max_x = center_x + (coord_t)outer;
+        display.min_y = center_y - (coord_t)outer;
+        display.max_y = center_y + (coord_t)outer;
+        display.screen_width = side;
+        display.screen_height = side;
+
+        prepare_frame(&band.frame, display);
+        render_pool_run(pool, exponential_map_row, &band, band.rows);
+        release_frame(&band.frame);
+
+        fwrite(band.pixels, 1, (size_t)band.rows * band.bytes_per_row, image);
+
+    }
+
+    fclose(image);
+    double render_time = monotonic_seconds() - start;
+
+    printf("%s: %dx%d exponential map, radius %Lg to %Lg, %s palette, %s kernel, %d threads\n",
+           file_name, width, height, outer_radius, inner_radius, palette_names[palette],
+           escape_engine->name, render_threads);
+    printf("render %.3f s, %.2f Mpixel/s\n", render_time, (double)width * height / render_time / 1e6);
+
+    if(render_pool != NULL){
+        render_pool_destroy(render_pool);
+    }
+
+    free(cosines);
+    free(sines);
+    free(band.pixels);
+    free_color_table(band.table);
+
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////
+// exponential_map_row:                                                //
+//   compute and color one row of an exponential map band, called by  //
+//   workers                                                           //
+/////////////////////////////////////////////////////////////////////////
+void exponential_map_row(void *context, int row){
+
+    map_band_t *band = context;
+
+    // offsets from the center stay in double, they are small next to the center but not
+    // next to each other
+    double radius = band->outer_radius * expl(-2 * M_PI * (band->first_row + row) / band->width);
+
+    // band rows are kept in file order, bottom row first
+    unsigned char *pixel = band->pixels + (size_t)(band->rows - 1 - row) * band->bytes_per_row;
+
+    int start;
+    for(start = 0; start < band->width; start += SPAN_CHUNK){
+
+        int count = (band->width - start < SPAN_CHUNK) ? band->width - start : SPAN_CHUNK;
+        double dx[SPAN_CHUNK], dy[SPAN_CHUNK], mu[SPAN_CHUNK];
+
+        int k;
+        for(k = 0; k < count; k++){
+            dx[k] = radius * band->cosines[start + k];
+            dy[k] = radius * band->sines[start + k];
+        }
+
+        compute_offsets(&band->frame, dx, dy, count, mu);
+        color_row(band->table, mu, count, pixel + start * 3);
+
+    }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// render_distributed:                                                       //
+//   export display as a bitmap split into bands of rows, rendered by       //
+//   local_workers local worker processes and one worker per command. each  //
+//   worker is sent the image once, then one band at a time, and its reply //
+//   is written to the band's place in the file. bands of failed workers    //
+//   go back to the queue, and idle workers take a second copy of bands     //
+//   running much longer than average, the first copy back is kept. with a  //
+//   timeout, workers running longer than that on a band are restarted      //
+///////////////////////////////////////////////////////////////////////////////
+void render_distributed(char *file_name, window_t display, COLOR_PALETTE palette, const char *kernel_name,
+                        int local_workers, char **commands, int n_commands, int timeout){
+
+    farm_t farm;
+    memset(&farm, 0, sizeof(farm));
+
+    // the same exact window and limit draw_bitmap would render
+    memcpy(farm.image.magic, FARM_MAGIC, 4);
+    farm.image.display = display;
+    farm.image.iterations = choose_iterations(display);
+    farm.image.precision = choose_precision(display);
+    farm.image.palette = palette;
+    farm.image.formula = fractal_formula;
+    farm.image.julia_r = julia_r;
+    farm.image.julia_i = julia_i;
+    farm.image.distance_render = distance_render;
+    farm.image.boundary_width = boundary_width;
+    farm.image.antialias_samples = antialias_samples;
+    farm.image.antialias_threshold = antialias_threshold;
+    farm.image.strict_render = strict_render;
+
+    int width = display.screen_width;
+    int height = display.screen_height;
+    farm.bytes_per_row = (((24 * width) + 31) / 32) * 4;
+
+    // local workers share the threads of this machine
+    farm.n_workers = local_workers + n_commands;
+    farm.kernel_name = kernel_name;
+    farm.timeout = timeout;
+    farm.worker_threads = local_workers > 0 ? render_threads / local_workers : 1;
+
+    if(farm.worker_threads < 1){
+        farm.worker_threads = 1;
+    }
+
+    // enough bands that every worker gets several
+    farm.band_rows = FARM_BAND_PIXELS / width;
+    int spread_rows = (height + farm.n_workers * FARM_BANDS_PER_WORKER - 1) / (farm.n_workers * FARM_BANDS_PER_WORKER);
+
+    if(farm.band_rows > spread_rows){
+        farm.band_rows = spread_rows;
+    }
+
+    if(farm.band_rows < 1){
+        farm.band_rows = 1;
+    }
+
+    farm.n_bands = (height + farm.band_rows - 1) / farm.band_rows;
+    farm.remaining = farm.n_bands;
+    farm.done = calloc(farm.n_bands, sizeof(int));
+    farm.copies = calloc(farm.n_bands, sizeof(int));
+    farm.started = calloc(farm.n_bands, sizeof(double));
+    farm.workers = calloc(farm.n_workers, sizeof(farm_worker_t));
+
+    if(farm.done == NULL || farm.copies == NULL || farm.started == NULL || farm.workers == NULL){
+        fprintf(stderr, "error allocating memory for distributed export\n");
+        exit(1);
+    }
+
+    // the file is sized up front and bands are written to their place as they come back
+    size_t file_size = BITMAP_HEADER_SIZE + (size_t)farm.bytes_per_row * height;
+    unsigned char header[BITMAP_HEADER_SIZE];
+    fill_bitmap_header(header, width, height, farm.bytes_per_row);
+
+    farm.fd = open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if(farm.fd < 0 || ftruncate(farm.fd, file_size) != 0 ||
+       pwrite(farm.fd, header, BITMAP_HEADER_SIZE, 0) != BITMAP_HEADER_SIZE){
+        fprintf(stderr, "error opening file for writing\n");
+        exit(1);
+    }
+
+    // dead workers show up as failed writes instead of killing the coordinator
+    signal(SIGPIPE, SIG_IGN);
+
+    double start = monotonic_seconds();
+
+    int w;
+    for(w = 0; w < farm.n_workers; w++){
+
+        farm_worker_t *worker = &farm.workers[w];
+        worker->command = w < local_workers ? NULL : commands[w - local_workers];
+        worker->reply = malloc(sizeof(farm_job_t) + (size_t)farm.band_rows * farm.bytes_per_row);
+
+        if(worker->reply == NULL){
+            fprintf(stderr, "error allocating memory for worker replies\n");
+            exit(1);
+        }
+
+        start_farm_worker(&farm, worker);
+
+    }
+
+    struct pollfd *polled = malloc(farm.n_workers * sizeof(struct pollfd));
+    int *polled_worker = malloc(farm.n_workers * sizeof(int));
+
+    if(polled == NULL || polled_worker == NULL){
+        fprintf(stderr, "error allocating memory for distributed export\n");
+        exit(1);
+    }
+
+    while(farm.remaining > 0){
+
+        double now = monotonic_seconds();
+        int alive = 0;
+
+        // hand a band to every idle worker, restart the ones past the timeout
+        for(w = 0; w < farm.n_workers; w++){
+
+            farm_worker_t *worker = &farm.workers[w];
+
+            if(farm.timeout > 0 && worker->alive && worker->band >= 0 && now - worker->started > farm.timeout){
+                fail_farm_worker(&farm, worker, "timed out");
+            }
+
+            if(worker->alive && worker->band < 0){
+
+                int band = next_farm_band(&farm, now);
+
+                if(band >= 0){
+                    send_farm_band(&farm, worker, band);
+                }
+
+            }
+
+            alive += worker->alive;
+
+        }
+
+        if(alive == 0){
+            fprintf(stderr, "no workers left, %d of %d bands not rendered\n", farm.remaining, farm.n_bands);
+            exit(1);
+        }
+
+        // wait for replies from busy workers, waking up now and then to look for slow bands
+        int n_polled = 0;
+
+        for(w = 0; w < farm.n_workers; w++){
+            if(farm.workers[w].alive && farm.workers[w].band >= 0){
+                polled[n_polled].fd = farm.workers[w].from_worker;
+                polled[n_polled].events = POLLIN;
+                polled_worker[n_polled] = w;
+                n_polled++;
+            }
+        }
+
+        if(poll(polled, n_polled, 1000) < 0 && errno != EINTR){
+            fprintf(stderr, "error waiting for workers\n");
+            exit(1);
+        }
+
+        int p;
+        for(p = 0; p < n_polled; p++){
+
+            if(polled[p].revents == 0){
+                continue;
+            }
+
+            farm_worker_t *worker = &farm.workers[polled_worker[p]];
+            int status = read_farm_reply(&farm, worker);
+
+            if(status < 0){
+                fail_farm_worker(&farm, worker, "stopped answering");
+                continue;
+            }
+
+            if(status == 0){
+                continue;
+            }
+
+            // first copy of the band back is written, later ones are dropped
+            int band = worker->band;
+            farm.copies[band]--;
+
+            if(!farm.done[band]){
+
+                farm_job_t *job = (farm_job_t *)worker->reply;
+                size_t size = (size_t)job->rows * farm.bytes_per_row;
+                off_t offset = BITMAP_HEADER_SIZE + (off_t)(height - job->first_row - job->rows) * farm.bytes_per_row;
+
+                if(pwrite(farm.fd, worker->reply + sizeof(farm_job_t), size, offset) != (ssize_t)size){
+                    fprintf(stderr, "error writing file\n");
+                    exit(1);
+                }
+
+                farm.done[band] = TRUE;
+                farm.remaining--;
+                farm.band_seconds += monotonic_seconds() - worker->started;
+                farm.bands_timed++;
+
+            }
+
+            worker->band = -1;
+            worker->received = 0;
+
+        }
+
+    }
+
+    // idle workers stop at the end of their input, copies still running are stopped
+    for(w = 0; w < farm.n_workers; w++){
+        if(farm.workers[w].alive){
+            stop_farm_worker(&farm.workers[w], FALSE);
+        }
+        free(farm.workers[w].reply);
+    }
+
+    if(fsync(farm.fd) != 0 || close(farm.fd) != 0){
+        fprintf(stderr, "error writing file\n");
+        exit(1);
+    }
+
+    double render_time = monotonic_seconds() - start;
+
+    printf("%s: %dx%d, %s palette, %s precision, %d iterations%s, %d workers\n",
+           file_name, width, height, palette_names[palette], precision_names[farm.image.precision],
+           farm.image.iterations, iteration_limit > 0 ? "" : " (auto)", farm.n_workers);
+    printf("render %.3f s, %.2f Mpixel/s, %d bands, %d sent twice\n",
+           render_time, (double)width * height / render_time / 1e6, farm.n_bands, farm.resent);
+
+    free(polled);
+    free(polled_worker);
+    free(farm.workers);
+    free(farm.done);
+    free(farm.copies);
+    free(farm.started);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+// start_farm_worker:                                                    //
+//   start the worker's process with pipes on its stdin and stdout and  //
+//   send it the image. a worker that can't start fails on its first    //
+//   band                                                                //
+///////////////////////////////////////////////////////////////////////////
+void start_farm_worker(farm_t *farm, farm_worker_t *worker){
+
+    int to_worker[2], from_worker[2];
+
+    if(pipe(to_worker) != 0 || pipe(from_worker) != 0){
+        fprintf(stderr, "error creating pipes for worker\n");
+        exit(1);
+    }
+
+    // closed on exec, so no worker holds another one's pipes open
+    fcntl(to_worker[0], F_SETFD, FD_CLOEXEC);
+    fcntl(to_worker[1], F_SETFD, FD_CLOEXEC);
+    fcntl(from_worker[0], F_SETFD, FD_CLOEXEC);
+    fcntl(from_worker[1], F_SETFD, FD_CLOEXEC);
+
+    pid_t pid = fork();
+
+    if(pid < 0){
+        fprintf(stderr, "error starting worker\n");
+        exit(1);
+    }
+
+    if(pid == 0){
+
+        dup2(to_worker[0], STDIN_FILENO);
+        dup2(from_worker[1], STDOUT_FILENO);
+
+        if(worker->command != NULL){
+
+            execl("/bin/sh", "sh", "-c", worker->command, (char *)NULL);
+
+        }else{
+
+            // local workers run this program, splitting its threads
+            char threads[16];
+            snprintf(threads, sizeof(threads), "%d", farm->worker_threads);
+
+            char *args[] = {"mandelbrot-render", "-W", "-t", threads,
+                            farm->kernel_name != NULL ? "-k" : NULL, (char *)farm->kernel_name, NULL};
+            execv("/proc/self/exe", args);
+
+        }
+
+        fprintf(stderr, "error starting worker\n");
+        _exit(127);
+
+    }
+
+    close(to_worker[0]);
+    close(from_worker[1]);
+    fcntl(from_worker[0], F_SETFL, O_NONBLOCK);
+
+    worker->pid = pid;
+    worker->to_worker = to_worker[1];
+    worker->from_worker = from_worker[0];
+    worker->alive = TRUE;
+    worker->band = -1;
+    worker->received = 0;
+
+    // fits in the pipe, a failed write shows up again when the first band is sent
+    write_full(worker->to_worker, &farm->image, sizeof(farm_image_t));
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// stop_farm_worker:                                                  //
+//   close the worker's input and wait for it to exit, killing it     //
+//   first when it is still busy with a band or force is set          //
+////////////////////////////////////////////////////////////////////////
+void stop_farm_worker(farm_worker_t *worker, int force){
+
+    if(force || worker->band >= 0){
+        kill(worker->pid, SIGKILL);
+    }
+
+    close(worker->to_worker);
+    close(worker->from_worker);
+    waitpid(worker->pid, NULL, 0);
+
+    worker->alive = FALSE;
+    worker->band = -1;
+    worker->received = 0;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+// fail_farm_worker:                                                     //
+//   stop a worker that failed, putting its band back in the queue      //
+//   unless another copy is running, and restart it up to FARM_RESTARTS //
+//   times                                                               //
+///////////////////////////////////////////////////////////////////////////
+void fail_farm_worker(farm_t *farm, farm_worker_t *worker, const char *reason){
+
+    int band = worker->band;
+
+    if(band >= 0){
+
+        int first_row = band * farm->band_rows;
+        int last_row = first_row + farm->band_rows - 1;
+
+        if(last_row >= farm->image.display.screen_height){
+            last_row = farm->image.display.screen_height - 1;
+        }
+
+        fprintf(stderr, "worker %d %s on rows %d-%d\n", (int)(worker - farm->workers), reason, first_row, last_row);
+        farm->copies[band]--;
+
+    }else{
+        fprintf(stderr, "worker %d %s\n", (int)(worker - farm->workers), reason);
+    }
+
+    // killed outright, a hung worker wouldn't exit at the end of its input
+    stop_farm_worker(worker, TRUE);
+
+    if(worker->restarts < FARM_RESTARTS){
+        worker->restarts++;
+        start_farm_worker(farm, worker);
+    }else{
+        fprintf(stderr, "worker %d given up after %d restarts\n", (int)(worker - farm->workers), FARM_RESTARTS);
+    }
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////
+// send_farm_band:                                                  //
+//   hand a band to an idle worker                                  //
+//////////////////////////////////////////////////////////////////////
+void send_farm_band(farm_t *farm, farm_worker_t *worker, int band){
+
+    farm_job_t job;
+    job.first_row = band * farm->band_rows;
+    job.rows = farm->band_rows;
+
+    if(job.first_row + job.rows > farm->image.display.screen_height){
+        job.rows = farm->image.display.screen_height - job.first_row;
+    }
+
+    if(farm->copies[band] > 0){
+        farm->resent++;
+    }else{
+        farm->started[band] = monotonic_seconds();
+    }
+
+    worker->band = band;
+    worker->started = monotonic_seconds();
+    worker->received = 0;
+    farm->copies[band]++;
+
+    if(!write_full(worker->to_worker, &job, sizeof(job))){
+        fail_farm_worker(farm, worker, "could not be sent a band");
+    }
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// next_farm_band:                                                      //
+//   band an idle worker should compute next: the first one not done  //
+//   and not running, or else the longest running one once it has run  //
+//   FARM_SLOW_FACTOR times the average band time. -1 when there is    //
+//   nothing to do                                                      //
+//////////////////////////////////////////////////////////////////////////
+int next_farm_band(const farm_t *farm, double now){
+
+    int band;
+    for(band = 0; band < farm->n_bands; band++){
+        if(!farm->done[band] && farm->copies[band] == 0){
+            return band;
+        }
+    }
+
+    if(farm->bands_timed == 0){
+        return -1;
+    }
+
+    double slow = FARM_SLOW_FACTOR * farm->band_seconds / farm->bands_timed;
+    int slowest = -1;
+
+    for(band = 0; band < farm->n_bands; band++){
+        if(!farm->done[band] && farm->copies[band] == 1 && now - farm->started[band] > slow &&
+           (slowest < 0 || farm->started[band] < farm->started[slowest])){
+            slowest = band;
+        }
+    }
+
+    return slowest;
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+// read_farm_reply:                                                     //
+//   read what the worker has sent of its reply so far. returns 1 once //
+//   the whole band is in, 0 while more is to come, and -1 when the     //
+//   worker closed its output or sent something else                    //
+//////////////////////////////////////////////////////////////////////////
+int read_farm_reply(farm_t *farm, farm_worker_t *worker){
+
+    int first_row = worker->band * farm->band_rows;
+    int rows = farm->band_rows;
+
+    if(first_row + rows > farm->image.display.screen_height){
+        rows = farm->image.display.screen_height - first_row;
+    }
+
+    size_t size = sizeof(farm_job_t) + (size_t)rows * farm->bytes_per_row;
+
+    while(worker->received < size){
+
+        ssize_t n = read(worker->from_worker, worker->reply + worker->received, size - worker->received);
+
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+
+        if(n < 0 && errno == EAGAIN){
+            return 0;
+        }
+
+        if(n <= 0){
+            return -1;
+        }
+
+        worker->received += n;
+
+        // the header has to be the band that was asked for
+        if(worker->received >= sizeof(farm_job_t) && worker->received - n < sizeof(farm_job_t)){
+
+            farm_job_t *job = (farm_job_t *)worker->reply;
+
+            if(job->first_row != first_row || job->rows != rows){
+                return -1;
+            }
+
+        }
+
+    }
+
+    return 1;
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+// run_farm_worker:                                                         //
+//   render bands of the image read from stdin until stdin closes, writing //
+//   each band to stdout behind the job it answers                         //
+//////////////////////////////////////////////////////////////////////////////
+void run_farm_worker(){
+
+    farm_image_t image;
+
+    if(!read_full(STDIN_FILENO, &image, sizeof(image))){
+        return;
+    }
+
+    if(memcmp(image.magic, FARM_MAGIC, 4) != 0){
+        fprintf(stderr, "worker: input is not a distributed export\n");
+        exit(1);
+    }
+
+    // render settings come from the coordinator, nothing is rendered twice so tiles aren't kept
+    iteration_limit = image.iterations;
+    precision_override = image.precision;
+    fractal_formula = image.formula;
+    julia_r = image.julia_r;
+    julia_i = image.julia_i;
+    distance_render = image.distance_render;
+    boundary_width = image.boundary_width;
+    antialias_samples = image.antialias_samples;
+    antialias_threshold = image.antialias_threshold;
+    strict_render = image.strict_render;
+    tile_cache_megabytes = 0;
+
+    window_t display = image.display;
+
+    bitmap_band_t band;
+    memset(&band, 0, sizeof(band));
+    band.width = display.screen_width;
+    band.bytes_per_row = (((24 * band.width) + 31) / 32) * 4;
+    band.table = create_color_table(image.palette);
+
+    // the same frames as a streamed draw_bitmap, the fine one prepared first
+    if(antialias_samples > 1){
+
+        window_t fine_window = display;
+        fine_window.screen_width *= antialias_samples;
+        fine_window.screen_height *= antialias_samples;
+        prepare_frame(&band.fine, fine_window);
+
+    }
+
+    prepare_frame(&band.frame, display);
+
+    int capacity = 0;
+    farm_job_t job;
+
+    while(read_full(STDIN_FILENO, &job, sizeof(job))){
+
+        if(job.first_row < 0 || job.rows < 1 || job.first_row + job.rows > display.screen_height){
+            fprintf(stderr, "worker: rows %d-%d are outside the image\n", job.first_row, job.first_row + job.rows - 1);
+            exit(1);
+        }
+
+        // zeroed so row padding is already in place. escape values have room for a row
+        // above and below the band
+        if(job.rows > capacity){
+
+            free(band.mu);
+            free(band.pixels);
+            capacity = job.rows;
+            band.mu = malloc((size_t)(capacity + 2) * band.width * sizeof(double));
+            band.pixels = calloc((size_t)capacity * band.bytes_per_row, 1);
+
+            if(band.mu == NULL || band.pixels == NULL){
+                fprintf(stderr, "worker: error allocating memory for bitmap band\n");
+                exit(1);
+            }
+
+        }
+
+        band.first_row = job.first_row;
+        band.rows = job.rows;
+
+        // edges across band borders are found as in draw_bitmap, from a row of the next bands
+        if(antialias_samples > 1){
+            band.rows_above = job.first_row > 0 ? 1 : 0;
+            band.rows_below = job.first_row + job.rows < display.screen_height ? 1 : 0;
+        }
+
+        render_band(get_render_pool(), &band);
+
+        if(!write_full(STDOUT_FILENO, &job, sizeof(job)) ||
+           !write_full(STDOUT_FILENO, band.pixels, (size_t)job.rows * band.bytes_per_row)){
+            exit(1);
+        }
+
+    }
+
+    release_frame(&band.frame);
+
+    if(antialias_samples > 1){
+        release_frame(&band.fine);
+    }
+
+    free(band.mu);
+    free(band.pixels);
+    free_color_table((color_table_t *)band.table);
+
+}
+
+
+
+////////////////////////////////////////////////////////////////
+// read_full:                                                 //
+//   read exactly size bytes, FALSE at end of input or error //
+////////////////////////////////////////////////////////////////
+int read_full(int fd, void *buffer, size_t size){
+
+    size_t done = 0;
+
+    while(done < size){
+
+        ssize_t n = read(fd, (char *)buffer + done, size - done);
+
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+
+        if(n <= 0){
+            return FALSE;
+        }
+
+        done += n;
+
+    }
+
+    return TRUE;
+
+}
+
+
+
+////////////////////////////////////////////////////////////////
+// write_full:                                                //
+//   write exactly size bytes, FALSE on error                 //
+////////////////////////////////////////////////////////////////
+int write_full(int fd, const void *buffer, size_t size){
+
+    size_t done = 0;
+
+    while(done < size){
+
+        ssize_t n = write(fd, (const char *)buffer + done, size - done);
+
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+
+        if(n <= 0){
+            return FALSE;
+        }
+
+        done += n;
+
+    }
+
+    return TRUE;
+
+}
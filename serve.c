@@ -0,0 +1,913 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "fractal.h"
+
+// address listened on when none is given, and pixels per side of a tile
+#define SERVE_ADDRESS "127.0.0.1:8080"
+#define SERVE_TILE_SIZE 256
+#define SERVE_MAX_TILE_SIZE 2048
+
+// tile 0/0/0 covers the square of this width around 0, which holds every point of
+// the sets drawn. tiles on the zoom level past SERVE_MAX_ZOOM would need x and y
+// past 2^62
+#define SERVE_WORLD_SIZE 4
+#define SERVE_MAX_ZOOM 62
+
+// highest iteration limit a request can ask for
+#define SERVE_MAX_ITERATIONS (1 << 24)
+
+// tile cache budget when none is given, tiles of a map are requested again and
+// again so it is larger than for a single export
+#define SERVE_CACHE_MEGABYTES 512
+
+// connections waiting for a thread, bytes read of a request before it is rejected,
+// and seconds a client gets to send its request or take the reply
+#define SERVE_QUEUE 256
+#define SERVE_REQUEST_BYTES 4096
+#define SERVE_TIMEOUT 30
+
+///////////////////////////
+// Structure definitions //
+///////////////////////////
+
+// tile asked for by one request, x counts east and y south from the top left tile
+typedef struct {
+
+    int z;
+    long x;
+    long y;
+
+    COLOR_PALETTE palette;
+    int iterations;
+
+    // BMP file, or raw RGB rows top row first
+    int raw;
+
+}tile_request_t;
+
+// thread serving connections, tiles are rendered on the thread itself so every
+// thread has a pool of one and its own band buffers
+typedef struct {
+
+    int id;
+    pthread_t thread;
+    render_pool_t *pool;
+
+    bitmap_band_t band;
+    unsigned char *rgb;
+
+    // tile being rendered, other threads asking for it wait for it to be cached
+    tile_request_t rendering;
+    int busy;
+
+}serve_thread_t;
+
+// accepted connections waiting for a thread
+typedef struct {
+
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+
+    int fds[SERVE_QUEUE];
+    int first;
+    int count;
+    int shutdown;
+
+}connection_queue_t;
+
+//////////////////////////
+// Function definitions //
+//////////////////////////
+
+void usage(char *program);
+int listen_tcp(char *address);
+int listen_unix(char *path);
+void stop(int signal_number);
+void *serve_connections(void *arg);
+void serve_connection(serve_thread_t *thread, int fd);
+int parse_request(char *request, tile_request_t *tile);
+void render_tile(serve_thread_t *thread, const tile_request_t *tile);
+void wait_for_tile(serve_thread_t *thread, const tile_request_t *tile);
+void send_reply(int fd, const char *status, const char *content_type, const void *body, size_t size,
+                const void *more, size_t more_size);
+int send_full(int fd, const void *buffer, size_t size);
+
+
+/////////////
+// Globals //
+/////////////
+
+// pixels per side of every tile served, and the palette and iteration limit of
+// requests that don't name their own
+int tile_size = SERVE_TILE_SIZE;
+COLOR_PALETTE default_palette = GOLDEN_PURPLE;
+int default_iterations = 0;
+
+// color table of every palette, shared by all threads
+color_table_t *palette_tables[MATRIX + 1];
+
+// threads serving connections and the connections waiting for them
+serve_thread_t *serve_threads;
+connection_queue_t connections;
+
+// guards the tiles being rendered by each thread
+pthread_mutex_t tile_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t tile_done = PTHREAD_COND_INITIALIZER;
+
+// tiles served and requests turned down
+long tiles_served = 0;
+long requests_rejected = 0;
+
+// set by SIGINT or SIGTERM
+volatile sig_atomic_t stopping = FALSE;
+
+
+///////////////////////////////////////////////////////////////////////////
+// main:                                                                 //
+//   render map tiles for requests on a tcp or unix socket until stopped //
+///////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv){
+
+    char *kernel_name = NULL;
+    char *address = NULL;
+    char *socket_path = NULL;
+
+    // julia constant as read, coord_t has no scanf conversion
+    long double julia_constant[2];
+
+    tile_cache_megabytes = SERVE_CACHE_MEGABYTES;
+
+    // parse command line options
+    int opt;
+    while((opt = getopt(argc, argv, "l:u:w:P:i:f:J:a:A:b:k:t:p:sc:")) != -1){
+        switch(opt){
+
+            // [host:]port to listen on
+            case 'l':
+                address = optarg;
+            break;
+
+            // unix socket to listen on
+            case 'u':
+                socket_path = optarg;
+            break;
+
+            // pixels per side of a tile
+            case 'w':
+                tile_size = atoi(optarg);
+            break;
+
+            // palette of requests that don't name one
+            case 'P':
+                for(default_palette = GOLDEN_PURPLE; default_palette <= MATRIX; default_palette++){
+                    if(strcmp(optarg, palette_names[default_palette]) == 0){
+                        break;
+                    }
+                }
+                if(default_palette > MATRIX){
+                    usage(argv[0]);
+                }
+            break;
+
+            // iteration limit of requests that don't give one, 0 or auto adapts it to the zoom
+            case 'i':
+                default_iterations = atoi(optarg);
+            break;
+
+            // formula by name
+            case 'f':
+                for(fractal_formula = MANDELBROT; fractal_formula < FORMULAS; fractal_formula++){
+                    if(strcmp(optarg, formula_names[fractal_formula]) == 0){
+                        break;
+                    }
+                }
+                if(fractal_formula == FORMULAS){
+                    usage(argv[0]);
+                }
+            break;
+
+            // constant of the julia set as real,imaginary
+            case 'J':
+                if(sscanf(optarg, "%Lf,%Lf", &julia_constant[0], &julia_constant[1]) != 2){
+                    usage(argv[0]);
+                }
+                julia_r = julia_constant[0];
+                julia_i = julia_constant[1];
+            break;
+
+            // samples per side of edge pixels, and the escape value difference that marks them
+            case 'a':
+                antialias_samples = atoi(optarg);
+            break;
+
+            case 'A':
+                antialias_threshold = atof(optarg);
+            break;
+
+            // draw points closer to the set than this many pixels as part of it
+            case 'b':
+                distance_render = TRUE;
+                boundary_width = atof(optarg);
+            break;
+
+            // force a specific escape kernel
+            case 'k':
+                kernel_name = optarg;
+            break;
+
+            // number of threads serving requests, each renders its tiles by itself
+            case 't':
+                render_threads = atoi(optarg);
+            break;
+
+            // force a precision tier
+            case 'p':
+                for(precision_override = PRECISION_FLOAT; precision_override < PRECISION_AUTO; precision_override++){
+                    if(strcmp(optarg, precision_names[precision_override]) == 0){
+                        break;
+                    }
+                }
+                if(precision_override == PRECISION_AUTO){
+                    usage(argv[0]);
+                }
+            break;
+
+            // iterate every pixel instead of filling uniform rectangles
+            case 's':
+                strict_render = TRUE;
+            break;
+
+            // tile cache budget in megabytes, 0 turns it off
+            case 'c':
+                tile_cache_megabytes = atoi(optarg);
+            break;
+
+            default:
+                usage(argv[0]);
+
+        }
+    }
+
+    if((address != NULL && socket_path != NULL) || tile_size < 1 || tile_size > SERVE_MAX_TILE_SIZE ||
+       default_iterations < 0 || default_iterations > SERVE_MAX_ITERATIONS ||
+       antialias_samples > ANTIALIAS_MAX_SAMPLES){
+        usage(argv[0]);
+    }
+
+    // default to one thread per cpu
+    if(render_threads < 1){
+        render_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    // pick fastest escape kernel supported by this cpu
+    init_escape_kernel(kernel_name);
+
+    int listener = socket_path != NULL ? listen_unix(socket_path) : listen_tcp(address != NULL ? address : SERVE_ADDRESS);
+
+    // stop on SIGINT or SIGTERM, without restarting accept so the loop sees it
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    // clients that hang up early are seen as failed sends
+    signal(SIGPIPE, SIG_IGN);
+
+    COLOR_PALETTE palette;
+    for(palette = GOLDEN_PURPLE; palette <= MATRIX; palette++){
+        palette_tables[palette] = create_color_table(palette);
+    }
+
+    pthread_mutex_init(&connections.lock, NULL);
+    pthread_cond_init(&connections.not_empty, NULL);
+    pthread_cond_init(&connections.not_full, NULL);
+
+    serve_threads = calloc(render_threads, sizeof(serve_thread_t));
+
+    if(serve_threads == NULL){
+        fprintf(stderr, "error allocating memory for threads\n");
+        exit(1);
+    }
+
+    int bytes_per_row = (((24 * tile_size) + 31) / 32) * 4;
+
+    // threads start with the signals blocked so they always interrupt accept
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    int i;
+    for(i = 0; i < render_threads; i++){
+
+        serve_thread_t *thread = &serve_threads[i];
+        thread->id = i;
+        thread->pool = render_pool_create(1);
+
+        // zeroed so row padding is already in place. with antialiasing, escape values are
+        // also computed one pixel around the tile, edges on its borders are found as in
+        // one large export
+        int apron = antialias_samples > 1 ? 1 : 0;
+        thread->band.width = tile_size;
+        thread->band.bytes_per_row = bytes_per_row;
+        thread->band.first_row = 0;
+        thread->band.rows = tile_size;
+        thread->band.rows_above = apron;
+        thread->band.rows_below = apron;
+        thread->band.cols_beside = apron;
+        thread->band.mu = malloc((size_t)(tile_size + 2 * apron) * (tile_size + 2 * apron) * sizeof(double));
+        thread->band.pixels = calloc((size_t)tile_size * bytes_per_row, 1);
+        thread->rgb = malloc((size_t)tile_size * tile_size * 3);
+
+        if(thread->band.mu == NULL || thread->band.pixels == NULL || thread->rgb == NULL){
+            fprintf(stderr, "error allocating memory for tiles\n");
+            exit(1);
+        }
+
+        if(pthread_create(&thread->thread, NULL, serve_connections, thread) != 0){
+            fprintf(stderr, "error starting thread\n");
+            exit(1);
+        }
+
+    }
+
+    pthread_sigmask(SIG_UNBLOCK, &signals, NULL);
+
+    fprintf(stderr, "serving %dx%d %s tiles on %s, %d threads, %s kernel, %d MB tile cache\n",
+            tile_size, tile_size, formula_names[fractal_formula],
+            socket_path != NULL ? socket_path : address != NULL ? address : SERVE_ADDRESS,
+            render_threads, escape_engine->name, tile_cache_megabytes);
+
+    // hand connections to the threads, waiting while all of them are busy and the queue is full
+    while(!stopping){
+
+        int fd = accept(listener, NULL, NULL);
+
+        if(fd < 0){
+
+            if(errno != EINTR && errno != ECONNABORTED){
+                perror("accept");
+            }
+
+            continue;
+
+        }
+
+        // a client that stops sending or reading doesn't hold a thread for long
+        struct timeval timeout = {SERVE_TIMEOUT, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        pthread_mutex_lock(&connections.lock);
+
+        while(connections.count == SERVE_QUEUE){
+            pthread_cond_wait(&connections.not_full, &connections.lock);
+        }
+
+        connections.fds[(connections.first + connections.count) % SERVE_QUEUE] = fd;
+        connections.count++;
+        pthread_cond_signal(&connections.not_empty);
+
+        pthread_mutex_unlock(&connections.lock);
+
+    }
+
+    close(listener);
+
+    if(socket_path != NULL){
+        unlink(socket_path);
+    }
+
+    // threads finish the connections already accepted, then exit
+    pthread_mutex_lock(&connections.lock);
+    connections.shutdown = TRUE;
+    pthread_cond_broadcast(&connections.not_empty);
+    pthread_mutex_unlock(&connections.lock);
+
+    for(i = 0; i < render_threads; i++){
+
+        serve_thread_t *thread = &serve_threads[i];
+        pthread_join(thread->thread, NULL);
+
+        render_pool_destroy(thread->pool);
+        free(thread->band.mu);
+        free(thread->band.pixels);
+        free(thread->rgb);
+
+    }
+
+    fprintf(stderr, "served %ld tiles, rejected %ld requests, tile cache %ld hits %ld misses %ld evictions\n",
+            tiles_served, requests_rejected, tile_cache.hits, tile_cache.misses, tile_cache.evictions);
+
+    for(palette = GOLDEN_PURPLE; palette <= MATRIX; palette++){
+        free_color_table(palette_tables[palette]);
+    }
+
+    free(serve_threads);
+    tile_cache_destroy();
+
+    return 0;
+
+}
+
+
+
+////////////////////////////////////////////////
+// usage:                                     //
+//   print command line options and exit      //
+////////////////////////////////////////////////
+void usage(char *program){
+
+    fprintf(stderr, "usage: %s [-l [host:]port | -u socket] [-w tile_size] [-P palette] [-i iterations|auto]\n"
+                    "       [-f mandelbrot|julia|multibrot3|multibrot4|burning_ship] [-J real,imaginary]\n"
+                    "       [-a samples] [-A threshold] [-b pixels] [-k scalar|sse2|avx2|avx512] [-t threads]\n"
+                    "       [-p float|double|extended|quad|perturb] [-s] [-c megabytes]\n"
+                    "requests: GET /z/x/y.bmp or /z/x/y.rgb, with ?palette=name&iterations=n\n", program);
+    exit(1);
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////
+// listen_tcp:                                                  //
+//   listen on [host:]port, host defaults to the loopback      //
+//   address so tiles aren't served to other machines unasked   //
+//////////////////////////////////////////////////////////////////
+int listen_tcp(char *address){
+
+    char host[256] = "127.0.0.1";
+    char *port = strrchr(address, ':');
+
+    if(port == NULL){
+        port = address;
+    }else{
+
+        if(port - address >= (long)sizeof(host)){
+            fprintf(stderr, "host name too long: %s\n", address);
+            exit(1);
+        }
+
+        memcpy(host, address, port - address);
+        host[port - address] = '\0';
+        port++;
+
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    struct addrinfo *addresses;
+    int error = getaddrinfo(host, port, &hints, &addresses);
+
+    if(error != 0){
+        fprintf(stderr, "can't resolve %s: %s\n", address, gai_strerror(error));
+        exit(1);
+    }
+
+    int listener = socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+
+    // a restarted server can take the port back straight away
+    int reuse = 1;
+    if(listener >= 0){
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
+
+    if(listener < 0 || bind(listener, addresses->ai_addr, addresses->ai_addrlen) != 0 || listen(listener, SOMAXCONN) != 0){
+        fprintf(stderr, "can't listen on %s: %s\n", address, strerror(errno));
+        exit(1);
+    }
+
+    freeaddrinfo(addresses);
+    return listener;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////
+// listen_unix:                                                  //
+//   listen on a unix socket at path, replacing a stale socket  //
+//   left there by a server that didn't stop cleanly            //
+///////////////////////////////////////////////////////////////////
+int listen_unix(char *path){
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if(strlen(path) >= sizeof(address.sun_path)){
+        fprintf(stderr, "socket path too long: %s\n", path);
+        exit(1);
+    }
+
+    strcpy(address.sun_path, path);
+
+    // only sockets are removed, never another kind of file given by mistake
+    struct stat existing;
+    if(lstat(path, &existing) == 0 && S_ISSOCK(existing.st_mode)){
+        unlink(path);
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if(listener < 0 || bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+       listen(listener, SOMAXCONN) != 0){
+        fprintf(stderr, "can't listen on %s: %s\n", path, strerror(errno));
+        exit(1);
+    }
+
+    return listener;
+
+}
+
+
+
+////////////////////////////////////////////
+// stop:                                  //
+//   signal handler, stop accepting       //
+////////////////////////////////////////////
+void stop(int signal_number){
+
+    (void)signal_number;
+    stopping = TRUE;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////
+// serve_connections:                                                //
+//   thread body, serves queued connections until the server stops  //
+///////////////////////////////////////////////////////////////////////
+void *serve_connections(void *arg){
+
+    serve_thread_t *thread = arg;
+
+    while(TRUE){
+
+        pthread_mutex_lock(&connections.lock);
+
+        while(connections.count == 0 && !connections.shutdown){
+            pthread_cond_wait(&connections.not_empty, &connections.lock);
+        }
+
+        if(connections.count == 0){
+            pthread_mutex_unlock(&connections.lock);
+            break;
+        }
+
+        int fd = connections.fds[connections.first];
+        connections.first = (connections.first + 1) % SERVE_QUEUE;
+        connections.count--;
+        pthread_cond_signal(&connections.not_full);
+
+        pthread_mutex_unlock(&connections.lock);
+
+        serve_connection(thread, fd);
+        close(fd);
+
+    }
+
+    return NULL;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+// serve_connection:                                                     //
+//   read one http request from fd and answer it with a tile or an      //
+//   error. the connection is closed after every reply                   //
+///////////////////////////////////////////////////////////////////////////
+void serve_connection(serve_thread_t *thread, int fd){
+
+    char request[SERVE_REQUEST_BYTES + 1];
+    size_t length = 0;
+
+    // only the request line is used, the headers are read so the client isn't reset
+    while(length < SERVE_REQUEST_BYTES){
+
+        ssize_t n = recv(fd, request + length, SERVE_REQUEST_BYTES - length, 0);
+
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+
+        if(n <= 0){
+            return;
+        }
+
+        length += n;
+        request[length] = '\0';
+
+        if(strstr(request, "\r\n\r\n") != NULL || strstr(request, "\n\n") != NULL){
+            break;
+        }
+
+    }
+
+    request[length] = '\0';
+
+    tile_request_t tile;
+    int status = parse_request(request, &tile);
+
+    if(status != 200){
+
+        __atomic_fetch_add(&requests_rejected, 1, __ATOMIC_RELAXED);
+
+        const char *line = status == 404 ? "404 Not Found" : status == 405 ? "405 Method Not Allowed" : "400 Bad Request";
+        send_reply(fd, line, "text/plain", line + 4, strlen(line + 4), "\n", 1);
+        return;
+
+    }
+
+    render_tile(thread, &tile);
+
+    bitmap_band_t *band = &thread->band;
+
+    if(tile.raw){
+
+        // bitmap rows are bottom up and BGR
+        int row, col;
+        for(row = 0; row < tile_size; row++){
+
+            const unsigned char *in = band->pixels + (size_t)(tile_size - 1 - row) * band->bytes_per_row;
+            unsigned char *out = thread->rgb + (size_t)row * tile_size * 3;
+
+            for(col = 0; col < tile_size; col++){
+                out[col * 3] = in[col * 3 + 2];
+                out[col * 3 + 1] = in[col * 3 + 1];
+                out[col * 3 + 2] = in[col * 3];
+            }
+
+        }
+
+        send_reply(fd, "200 OK", "application/octet-stream", thread->rgb, (size_t)tile_size * tile_size * 3, NULL, 0);
+
+    }else{
+
+        unsigned char header[BITMAP_HEADER_SIZE];
+        fill_bitmap_header(header, tile_size, tile_size, band->bytes_per_row);
+
+        send_reply(fd, "200 OK", "image/bmp", header, BITMAP_HEADER_SIZE,
+                   band->pixels, (size_t)tile_size * band->bytes_per_row);
+
+    }
+
+    __atomic_fetch_add(&tiles_served, 1, __ATOMIC_RELAXED);
+
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+// parse_request:                                                           //
+//   read the tile asked for by "GET /z/x/y.bmp?palette=p&iterations=n".  //
+//   returns 200, or the http status to answer a bad request with. query   //
+//   parameters it doesn't know are ignored                                 //
+//////////////////////////////////////////////////////////////////////////////
+int parse_request(char *request, tile_request_t *tile){
+
+    char method[8];
+    char target[1024];
+
+    if(sscanf(request, "%7s %1023s", method, target) != 2){
+        return 400;
+    }
+
+    if(strcmp(method, "GET") != 0){
+        return 405;
+    }
+
+    tile->palette = default_palette;
+    tile->iterations = default_iterations;
+
+    char *query = strchr(target, '?');
+
+    if(query != NULL){
+        *query++ = '\0';
+    }
+
+    char format[4];
+    int end = 0;
+
+    if(sscanf(target, "/%d/%ld/%ld.%3[a-z]%n", &tile->z, &tile->x, &tile->y, format, &end) != 4 || target[end] != '\0'){
+        return 404;
+    }
+
+    if(strcmp(format, "bmp") == 0){
+        tile->raw = FALSE;
+    }else if(strcmp(format, "rgb") == 0){
+        tile->raw = TRUE;
+    }else{
+        return 404;
+    }
+
+    if(tile->z < 0 || tile->z > SERVE_MAX_ZOOM || tile->x < 0 || tile->y < 0 ||
+       tile->x >= 1L << tile->z || tile->y >= 1L << tile->z){
+        return 404;
+    }
+
+    char *parameter;
+    char *rest = query;
+    while(query != NULL && (parameter = strtok_r(rest, "&", &rest)) != NULL){
+
+        if(strncmp(parameter, "palette=", 8) == 0){
+
+            for(tile->palette = GOLDEN_PURPLE; tile->palette <= MATRIX; tile->palette++){
+                if(strcmp(parameter + 8, palette_names[tile->palette]) == 0){
+                    break;
+                }
+            }
+
+            if(tile->palette > MATRIX){
+                return 400;
+            }
+
+        }else if(strncmp(parameter, "iterations=", 11) == 0){
+
+            char *digits_end;
+            long iterations = strtol(parameter + 11, &digits_end, 10);
+
+            if(strcmp(parameter + 11, "auto") == 0){
+                iterations = 0;
+            }else if(digits_end == parameter + 11 || *digits_end != '\0' ||
+                      iterations < 0 || iterations > SERVE_MAX_ITERATIONS){
+                return 400;
+            }
+
+            tile->iterations = iterations;
+
+        }
+
+    }
+
+    return 200;
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// render_tile:                                                              //
+//   render a tile into the thread's band. tiles sit on a grid of power of  //
+//   two spacing, so every tile of a zoom level is on the same snapped grid //
+//   and their escape values are shared through the tile cache             //
+///////////////////////////////////////////////////////////////////////////////
+void render_tile(serve_thread_t *thread, const tile_request_t *tile){
+
+    bitmap_band_t *band = &thread->band;
+
+    // exact in quad for every zoom level, x and y stay below 2^SERVE_MAX_ZOOM
+    coord_t span = (coord_t)SERVE_WORLD_SIZE / (coord_t)(1L << tile->z);
+
+    window_t display;
+    display.min_x = -(coord_t)SERVE_WORLD_SIZE / 2 + tile->x * span;
+    display.max_x = display.min_x + span;
+    display.max_y = (coord_t)SERVE_WORLD_SIZE / 2 - tile->y * span;
+    display.min_y = display.max_y - span;
+    display.screen_width = tile_size;
+    display.screen_height = tile_size;
+
+    band->table = palette_tables[tile->palette];
+
+    wait_for_tile(thread, tile);
+
+    // the global limit stays automatic, each tile passes its own. frames are
+    // prepared without the lock, the reference orbit can take a while
+    int iterations = tile->iterations > 0 ? tile->iterations : choose_iterations(display);
+
+    if(antialias_samples > 1){
+
+        window_t fine_window = display;
+        fine_window.screen_width *= antialias_samples;
+        fine_window.screen_height *= antialias_samples;
+        prepare_frame_iterations(&band->fine, fine_window, iterations);
+
+    }
+
+    prepare_frame_iterations(&band->frame, display, iterations);
+
+    render_band(thread->pool, band);
+
+    release_frame(&band->frame);
+
+    if(antialias_samples > 1){
+        release_frame(&band->fine);
+    }
+
+    // let threads waiting for the same tile take it from the cache
+    pthread_mutex_lock(&tile_lock);
+    thread->busy = FALSE;
+    pthread_cond_broadcast(&tile_done);
+    pthread_mutex_unlock(&tile_lock);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+// wait_for_tile:                                                        //
+//   wait while another thread renders the same tile in any palette, so //
+//   its cache entries are computed once and the thread waiting only     //
+//   recolors them. returns with the tile marked as rendered by thread   //
+///////////////////////////////////////////////////////////////////////////
+void wait_for_tile(serve_thread_t *thread, const tile_request_t *tile){
+
+    pthread_mutex_lock(&tile_lock);
+
+    int waiting = TRUE;
+    while(waiting){
+
+        waiting = FALSE;
+
+        int i;
+        for(i = 0; i < render_threads && !waiting; i++){
+
+            const tile_request_t *other = &serve_threads[i].rendering;
+
+            waiting = serve_threads[i].busy && other->z == tile->z && other->x == tile->x &&
+                      other->y == tile->y && other->iterations == tile->iterations;
+
+        }
+
+        if(waiting){
+            pthread_cond_wait(&tile_done, &tile_lock);
+        }
+
+    }
+
+    thread->rendering = *tile;
+    thread->busy = TRUE;
+
+    pthread_mutex_unlock(&tile_lock);
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////
+// send_reply:                                                            //
+//   send an http reply with body, followed by more when given, so a     //
+//   bitmap header and its rows go out without being copied together    //
+////////////////////////////////////////////////////////////////////////////
+void send_reply(int fd, const char *status, const char *content_type, const void *body, size_t size,
+                const void *more, size_t more_size){
+
+    char header[256];
+    int length = snprintf(header, sizeof(header),
+                          "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                          status, content_type, size + more_size);
+
+    // a client that hung up just misses its reply
+    if(send_full(fd, header, length) && send_full(fd, body, size) && more != NULL){
+        send_full(fd, more, more_size);
+    }
+
+}
+
+
+
+////////////////////////////////////////////////////////////////
+// send_full:                                                 //
+//   send exactly size bytes, FALSE on error                  //
+////////////////////////////////////////////////////////////////
+int send_full(int fd, const void *buffer, size_t size){
+
+    size_t done = 0;
+
+    while(done < size){
+
+        ssize_t n = send(fd, (const char *)buffer + done, size - done, 0);
+
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+
+        if(n <= 0){
+            return FALSE;
+        }
+
+        done += n;
+
+    }
+
+    return TRUE;
+
+}
@@ -0,0 +1,495 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fractal.h"
+
+// default frame size, and the radius the map starts at when none is given, the
+// default scale of mandelbrot-render
+#define DEFAULT_FRAME_WIDTH 1920
+#define DEFAULT_FRAME_HEIGHT 1080
+#define DEFAULT_RADIUS 3
+
+// most levels of detail kept for the map and the narrowest one, each level is half
+// the size of the previous one
+#define MAX_MAP_LEVELS 16
+#define MIN_LEVEL_WIDTH 8
+
+///////////////////////////
+// Structure definitions //
+///////////////////////////
+
+// exponential map written by mandelbrot-render -E, averaged down into levels of detail.
+// pixels are BGR, top row first
+typedef struct {
+
+    unsigned char *pixels[MAX_MAP_LEVELS];
+    int width[MAX_MAP_LEVELS];
+    int height[MAX_MAP_LEVELS];
+    int levels;
+
+}map_pyramid_t;
+
+// where a frame pixel falls in the map. frames of a zoom only differ by a shift of the
+// rows, so everything else is worked out once per frame size
+typedef struct {
+
+    // level of detail matching the pixel's footprint in the map, and the weight of the
+    // next coarser level out of 256
+    int level;
+    int mix;
+
+    // byte offsets of the columns on either side of the pixel's angle in both levels,
+    // and the weight of the second one out of 256
+    int col[2];
+    int next_col[2];
+    int col_weight[2];
+
+    // rows below the row whose radius is the frame width, in both levels
+    float depth[2];
+
+}pixel_lookup_t;
+
+// frame being unwrapped by the workers
+typedef struct {
+
+    const map_pyramid_t *map;
+    const pixel_lookup_t *lookup;
+    unsigned char *pixels;
+    int width;
+
+    // row whose radius is the frame width, in every level
+    float row_shift[MAX_MAP_LEVELS];
+
+}unwrap_frame_t;
+
+//////////////////////////
+// Function definitions //
+//////////////////////////
+
+void usage(char *program);
+void read_map(char *file_name, map_pyramid_t *map);
+void shrink_map(map_pyramid_t *map);
+pixel_lookup_t *make_lookup(const map_pyramid_t *map, int width, int height);
+void unwrap_row(void *context, int row);
+
+
+///////////////////////////////////////////////////////////////////////////
+// main:                                                                 //
+//   remap an exponential map into one frame, or a zoom sequence of them //
+///////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv){
+
+    char *map_name = NULL;
+    char *file_name = NULL;
+    int width = DEFAULT_FRAME_WIDTH;
+    int height = DEFAULT_FRAME_HEIGHT;
+
+    // radius of the map's top row, the frame width to start at and where a sequence ends
+    long double radius = DEFAULT_RADIUS;
+    long double scale = 0, end_scale = 0;
+    int frames = 1;
+
+    // parse command line options
+    int opt;
+    while((opt = getopt(argc, argv, "i:o:w:h:R:z:Z:n:t:")) != -1){
+        switch(opt){
+
+            // exponential map to read
+            case 'i':
+                map_name = optarg;
+            break;
+
+            // output bitmap, printf pattern for sequences, or - for raw BGR on stdout
+            case 'o':
+                file_name = optarg;
+            break;
+
+            // frame size in pixels
+            case 'w':
+                width = atoi(optarg);
+            break;
+
+            case 'h':
+                height = atoi(optarg);
+            break;
+
+            // radius the map was rendered from, its -z
+            case 'R':
+                radius = strtold(optarg, NULL);
+            break;
+
+            // width of the real axis in the first frame, and in the last one of a sequence
+            case 'z':
+                scale = strtold(optarg, NULL);
+            break;
+
+            case 'Z':
+                end_scale = strtold(optarg, NULL);
+            break;
+
+            // number of frames of a zoom sequence
+            case 'n':
+                frames = atoi(optarg);
+            break;
+
+            // number of render threads
+            case 't':
+                render_threads = atoi(optarg);
+            break;
+
+            default:
+                usage(argv[0]);
+
+        }
+    }
+
+    if(scale <= 0){
+        scale = radius;
+    }
+
+    if(map_name == NULL || file_name == NULL || width < 1 || height < 1 || radius <= 0 || frames < 1){
+        usage(argv[0]);
+    }
+
+    if(frames > 1 && (end_scale <= 0 || (strcmp(file_name, "-") != 0 && strchr(file_name, '%') == NULL))){
+        usage(argv[0]);
+    }
+
+    // default to one render thread per cpu
+    if(render_threads < 1){
+        render_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    map_pyramid_t map;
+    read_map(map_name, &map);
+    shrink_map(&map);
+
+    unwrap_frame_t frame;
+    frame.map = &map;
+    frame.lookup = make_lookup(&map, width, height);
+    frame.width = width;
+    frame.pixels = malloc((size_t)width * height * 3);
+
+    if(frame.pixels == NULL){
+        fprintf(stderr, "error allocating memory for frame\n");
+        exit(1);
+    }
+
+    render_pool_t *pool = get_render_pool();
+    double unwrap_time = 0;
+
+    int f;
+    for(f = 0; f < frames; f++){
+
+        // scales step by a constant ratio so the zoom looks steady
+        long double frame_scale = frames > 1 ? scale * powl(end_scale / scale, (long double)f / (frames - 1)) : scale;
+        double row_shift = logl(radius / frame_scale) * map.width[0] / (2 * M_PI);
+
+        int level;
+        for(level = 0; level < map.levels; level++){
+            frame.row_shift[level] = row_shift / (1 << level);
+        }
+
+        double start = monotonic_seconds();
+        render_pool_run(pool, unwrap_row, &frame, height);
+        unwrap_time += monotonic_seconds() - start;
+
+        write_frame(file_name, f, frame.pixels, width, height);
+
+    }
+
+    // stdout may be carrying the frames
+    fprintf(stderr, "%d frames from a %dx%d map, %d levels, unwrap %.3f s\n",
+            frames, map.width[0], map.height[0], map.levels, unwrap_time);
+
+    if(render_pool != NULL){
+        render_pool_destroy(render_pool);
+    }
+
+    int level;
+    for(level = 0; level < map.levels; level++){
+        free(map.pixels[level]);
+    }
+
+    free((void *)frame.lookup);
+    free(frame.pixels);
+
+    return 0;
+
+}
+
+
+
+////////////////////////////////////////////////
+// usage:                                     //
+//   print command line options and exit      //
+////////////////////////////////////////////////
+void usage(char *program){
+
+    fprintf(stderr, "usage: %s -i map.bmp -o file.bmp [-w width] [-h height] [-R radius]\n"
+                    "       [-z scale] [-n frames -Z end_scale] [-t threads]\n", program);
+    exit(1);
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// read_map:                                                                 //
+//   load a 24 bit bitmap written by mandelbrot-render -E into map level 0  //
+///////////////////////////////////////////////////////////////////////////////
+void read_map(char *file_name, map_pyramid_t *map){
+
+    FILE *image = fopen(file_name, "rb");
+
+    if(image == NULL){
+        fprintf(stderr, "error opening map for reading\n");
+        exit(1);
+    }
+
+    unsigned char header[BITMAP_HEADER_SIZE];
+
+    if(fread(header, 1, BITMAP_HEADER_SIZE, image) != BITMAP_HEADER_SIZE || header[0] != 'B' || header[1] != 'M'){
+        fprintf(stderr, "map is not a bitmap\n");
+        exit(1);
+    }
+
+    // fields are little endian
+    unsigned int offset = header[10] | header[11] << 8 | header[12] << 16 | (unsigned int)header[13] << 24;
+    int width = header[18] | header[19] << 8 | header[20] << 16 | header[21] << 24;
+    int height = header[22] | header[23] << 8 | header[24] << 16 | header[25] << 24;
+    int bits = header[28] | header[29] << 8;
+
+    if(bits != 24 || width < 1 || height < 1){
+        fprintf(stderr, "map must be a bottom up 24 bit bitmap\n");
+        exit(1);
+    }
+
+    int bytes_per_row = (((24 * width) + 31) / 32) * 4;
+
+    memset(map, 0, sizeof(map_pyramid_t));
+    map->width[0] = width;
+    map->height[0] = height;
+    map->pixels[0] = malloc((size_t)width * height * 3);
+    map->levels = 1;
+
+    unsigned char *row_buffer = malloc(bytes_per_row);
+
+    if(map->pixels[0] == NULL || row_buffer == NULL){
+        fprintf(stderr, "error allocating memory for map\n");
+        exit(1);
+    }
+
+    fseek(image, offset, SEEK_SET);
+
+    // bitmap rows are stored bottom up
+    int row;
+    for(row = height - 1; row >= 0; row--){
+
+        if(fread(row_buffer, 1, bytes_per_row, image) != (size_t)bytes_per_row){
+            fprintf(stderr, "map is truncated\n");
+            exit(1);
+        }
+
+        memcpy(map->pixels[0] + (size_t)row * width * 3, row_buffer, (size_t)width * 3);
+
+    }
+
+    free(row_buffer);
+    fclose(image);
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// shrink_map:                                                        //
+//   average each level of the map down into the next, two by two,   //
+//   until it gets too narrow                                         //
+////////////////////////////////////////////////////////////////////////
+void shrink_map(map_pyramid_t *map){
+
+    while(map->levels < MAX_MAP_LEVELS && map->width[map->levels - 1] / 2 >= MIN_LEVEL_WIDTH &&
+          map->height[map->levels - 1] / 2 >= 1){
+
+        int level = map->levels;
+        int width = map->width[level - 1] / 2;
+        int height = map->height[level - 1] / 2;
+        int source_width = map->width[level - 1];
+        const unsigned char *source = map->pixels[level - 1];
+
+        unsigned char *pixels = malloc((size_t)width * height * 3);
+
+        if(pixels == NULL){
+            fprintf(stderr, "error allocating memory for map\n");
+            exit(1);
+        }
+
+        int row, col, channel;
+        for(row = 0; row < height; row++){
+
+            const unsigned char *top = source + (size_t)(2 * row) * source_width * 3;
+            const unsigned char *bottom = top + (size_t)source_width * 3;
+            unsigned char *pixel = pixels + (size_t)row * width * 3;
+
+            for(col = 0; col < width; col++){
+                for(channel = 0; channel < 3; channel++){
+                    pixel[col * 3 + channel] = (top[col * 6 + channel] + top[col * 6 + 3 + channel] +
+                                                bottom[col * 6 + channel] + bottom[col * 6 + 3 + channel] + 2) / 4;
+                }
+            }
+
+        }
+
+        map->pixels[level] = pixels;
+        map->width[level] = width;
+        map->height[level] = height;
+        map->levels++;
+
+    }
+
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// make_lookup:                                                              //
+//   place every pixel of a width x height frame in the map. a pixel r      //
+//   pixels from the center is ln(width / r) * map_width / 2pi rows below   //
+//   the row whose radius is the frame width, and covers                    //
+//   map_width / (2pi r) map pixels each way                                //
+///////////////////////////////////////////////////////////////////////////////
+pixel_lookup_t *make_lookup(const map_pyramid_t *map, int width, int height){
+
+    pixel_lookup_t *lookup = malloc((size_t)width * height * sizeof(pixel_lookup_t));
+
+    if(lookup == NULL){
+        fprintf(stderr, "error allocating memory for frame lookup\n");
+        exit(1);
+    }
+
+    double rows_per_e = map->width[0] / (2 * M_PI);
+
+    int row, col, i;
+    for(row = 0; row < height; row++){
+        for(col = 0; col < width; col++){
+
+            pixel_lookup_t *pixel = &lookup[(size_t)row * width + col];
+
+            // pixels are placed like scale() places them, the center pixel is kept off 0
+            double x = col - width / 2.0;
+            double y = height / 2.0 - row;
+            double r = hypot(x, y);
+
+            if(r < 0.5){
+                r = 0.5;
+            }
+
+            double level = log2(rows_per_e / r);
+            level = level < 0 ? 0 : level;
+
+            pixel->level = (int)level;
+            pixel->mix = (int)((level - pixel->level) * 256 + 0.5);
+
+            if(pixel->level >= map->levels - 1){
+                pixel->level = map->levels - 1;
+                pixel->mix = 0;
+            }
+
+            double depth = log(width / r) * rows_per_e;
+
+            double angle = atan2(y, x);
+
+            if(angle < 0){
+                angle += 2 * M_PI;
+            }
+
+            // level l pixel i averages the level 0 pixels around 2^l i + (2^l - 1) / 2, columns
+            // wrap around the circle
+            for(i = 0; i < 2 && pixel->level + i < map->levels; i++){
+
+                int level_width = map->width[pixel->level + i];
+                double size = 1 << (pixel->level + i);
+                double position = (angle * rows_per_e - (size - 1) / 2) / size;
+                double first = floor(position);
+
+                int first_col = (int)first % level_width;
+                first_col += first_col < 0 ? level_width : 0;
+
+                pixel->col[i] = first_col * 3;
+                pixel->next_col[i] = (first_col + 1 < level_width ? first_col + 1 : 0) * 3;
+                pixel->col_weight[i] = (int)((position - first) * 256 + 0.5);
+                pixel->depth[i] = (depth - (size - 1) / 2) / size;
+
+            }
+
+        }
+    }
+
+    return lookup;
+
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+// unwrap_row:                                                        //
+//   fill one row of the frame from the two map levels closest to    //
+//   each pixel's footprint, called by workers                        //
+////////////////////////////////////////////////////////////////////////
+void unwrap_row(void *context, int row){
+
+    unwrap_frame_t *frame = context;
+    const map_pyramid_t *map = frame->map;
+
+    const pixel_lookup_t *lookup = frame->lookup + (size_t)row * frame->width;
+    unsigned char *pixel = frame->pixels + (size_t)row * frame->width * 3;
+
+    // fixed point throughout, every frame of a zoom goes through here
+    int col, channel, i;
+    for(col = 0; col < frame->width; col++){
+
+        const pixel_lookup_t *place = &lookup[col];
+        int levels = place->mix > 0 ? 2 : 1;
+        int color[2][3] = {{0}};
+
+        for(i = 0; i < levels; i++){
+
+            int level = place->level + i;
+            int height = map->height[level];
+            size_t bytes_per_row = (size_t)map->width[level] * 3;
+
+            // rows past the top or bottom of the map take the edge row
+            float y = place->depth[i] + frame->row_shift[level];
+            y = y < 0 ? 0 : y > height - 1 ? height - 1 : y;
+
+            int first_row = (int)y;
+            int row_weight = (int)((y - first_row) * 256);
+            int col_weight = place->col_weight[i];
+
+            const unsigned char *top = map->pixels[level] + first_row * bytes_per_row;
+            const unsigned char *bottom = first_row + 1 < height ? top + bytes_per_row : top;
+            const unsigned char *left_top = top + place->col[i], *right_top = top + place->next_col[i];
+            const unsigned char *left_bottom = bottom + place->col[i], *right_bottom = bottom + place->next_col[i];
+
+            for(channel = 0; channel < 3; channel++){
+
+                int upper = left_top[channel] * (256 - col_weight) + right_top[channel] * col_weight;
+                int lower = left_bottom[channel] * (256 - col_weight) + right_bottom[channel] * col_weight;
+                color[i][channel] = upper * (256 - row_weight) + lower * row_weight;
+
+            }
+
+        }
+
+        // colors are scaled by 2^16 here, and by 2^8 more once the levels are blended
+        for(channel = 0; channel < 3; channel++){
+            pixel[col * 3 + channel] = ((long)color[0][channel] * (256 - place->mix) +
+                                        (long)color[1][channel] * place->mix + (1L << 23)) >> 24;
+        }
+
+    }
+
+}